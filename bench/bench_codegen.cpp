@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include "../src/converter.hpp"
+#include "../include/ConstexprRegex.h"
+#include "abb_table.h"
+#include "abb_switch.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// generated C++ (constexpr table and switch/goto styles, built by
+// regex_generate_header) and compile_regex against the table-driven
+// interpreter. each engine counts leftmost-longest matches over the same
+// random text
+//
+// usage: bench_codegen [megabytes]
+//---------------------------------------------------------------------------------
+
+// compile-time check that the table style really is constexpr
+static_assert(abb_table::match("abb") && !abb_table::match("ab"), "generated table header is not constexpr");
+
+// the same regex compiled by the C++ compiler itself
+static constexpr auto abb_constexpr = compile_regex(BENCH_CODEGEN_REGEX);
+
+template <typename Longest>
+static size_t CountMatches(Longest longest, string_view text)
+{
+    size_t count = 0;
+    for (size_t pos = 0; pos <= text.size();)
+    {
+        size_t end = longest(text, pos);
+        if (end == string_view::npos)
+        {
+            pos++;
+            continue;
+        }
+        count++;
+        pos = (end > pos) ? end : pos + 1;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 32;
+
+    string text(megabytes << 20, 'a');
+    mt19937 rng(42);
+    for (char &c : text)
+        c = "abc"[rng() % 3];
+
+    DFA dfa = regexToDFA(BENCH_CODEGEN_REGEX);
+    CompiledDFA table = dfa.getCompiled();
+    table.setPrefilter(Prefilter()); // compare the automata alone
+
+    auto Time = [](auto &&body) {
+        double best = 1e300;
+        for (int run = 0; run < 3; run++)
+        {
+            auto begin = chrono::steady_clock::now();
+            body();
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - begin).count());
+        }
+        return best;
+    };
+
+    cout << BENCH_CODEGEN_REGEX << ": " << table.NumStates() << " DFA states, " << megabytes << " MiB" << endl;
+    cout << left << setw(14) << "engine" << right << setw(10) << "matches" << setw(12) << "MB/s" << endl;
+
+    // every engine is its own instantiation, so the generated code can inline
+    size_t expected = 0;
+    bool first = true;
+    auto Run = [&](const char *name, auto longest) {
+        size_t count = 0;
+        double seconds = Time([&]() { count = CountMatches(longest, text); });
+        if (first)
+            expected = count;
+        first = false;
+        cout << left << setw(14) << name << right << setw(10) << count << setw(12) << fixed << setprecision(0)
+             << text.size() / seconds / 1e6 << endl;
+        return count == expected;
+    };
+
+    bool agree = Run("interpreter", [&](string_view t, size_t pos) { return table.LongestMatch(t, pos); });
+    agree &= Run("gen-table", [](string_view t, size_t pos) { return abb_table::longest_match(t, pos); });
+    agree &= Run("gen-switch", [](string_view t, size_t pos) { return abb_switch::longest_match(t, pos); });
+    agree &= Run("constexpr", [](string_view t, size_t pos) { return abb_constexpr.LongestMatch(t, pos); });
+    if (!agree)
+    {
+        cerr << "the generated matchers disagree with the interpreter" << endl;
+        return 1;
+    }
+    return 0;
+}
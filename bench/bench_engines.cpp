@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "../include/Pattern.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// compile time, memory and find_all throughput of every matching engine on
+// small patterns, from DFA-friendly ones to (a|b)*.a.(a|b)^n whose DFA has
+// 2^(n+1) states. the auto column is the engine Pattern picks by itself
+//
+// usage: bench_engines [megabytes]
+//---------------------------------------------------------------------------------
+
+// (a|b)*.a.(a|b).(a|b)...
+static string Blowup(size_t n)
+{
+    string regex = "(a|b)*.a";
+    for (size_t i = 0; i < n; i++)
+        regex += ".(a|b)";
+    return regex;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 16;
+
+    string text(megabytes << 20, 'a');
+    mt19937 rng(42);
+    for (char &c : text)
+        c = "abc"[rng() % 3];
+
+    vector<pair<string, string>> regexes = {{"a.b.c", "a.b.c"},
+                                            {"(a|b)*.c.(a|b|c)", "(a|b)*.c.(a|b|c)"},
+                                            {"(a|b)*.a.(a|b)^8", Blowup(8)},
+                                            {"(a|b)*.a.(a|b)^16", Blowup(16)},
+                                            {"(a|b)*.a.(a|b)^24", Blowup(24)}};
+    struct Engine
+    {
+        const char *name;
+        MatchEngine engine;
+    };
+    vector<Engine> engines = {
+        {"full", MatchEngine::FULL_DFA}, {"lazy", MatchEngine::LAZY_DFA}, {"bit", MatchEngine::BIT_PARALLEL}};
+    const char *engineNames[] = {"full", "lazy", "bit", "auto"};
+
+    cout << megabytes << " MiB of random a/b/c" << endl;
+    cout << left << setw(20) << "regex" << setw(6) << "auto" << setw(8) << "engine" << right << setw(14)
+         << "compile ms" << setw(12) << "KiB" << setw(10) << "MB/s" << endl;
+
+    for (const auto &[label, regex] : regexes)
+    {
+        Pattern automatic(regex);
+        size_t expected = NO_MATCH;
+        for (const Engine &engine : engines)
+        {
+            PatternOptions options;
+            options.engine = engine.engine;
+            options.limits.max_states = 1 << 20; // the largest full DFA is out of reach
+            options.lazyFallback = false;
+
+            auto begin = chrono::steady_clock::now();
+            unique_ptr<Pattern> pattern;
+            try
+            {
+                pattern = make_unique<Pattern>(regex, options);
+            }
+            catch (const DFALimitExceeded &)
+            {
+                cout << left << setw(20) << label << setw(6) << engineNames[(int)automatic.Engine()]
+                     << setw(8) << engine.name << right << setw(14) << "too large" << endl;
+                continue;
+            }
+            double compileMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+            begin = chrono::steady_clock::now();
+            size_t count = pattern->find_all(text, [](size_t, size_t) {});
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            if (expected != NO_MATCH && count != expected)
+            {
+                cerr << label << ": " << engine.name << " found " << count << " matches, expected " << expected << endl;
+                return 1;
+            }
+            expected = count;
+
+            cout << left << setw(20) << label << setw(6) << engineNames[(int)automatic.Engine()]
+                 << setw(8) << engine.name << right << setw(14) << fixed << setprecision(3) << compileMs << setw(12)
+                 << setprecision(1) << pattern->MemoryBytes() / 1024.0 << setw(10) << setprecision(0)
+                 << text.size() / seconds / 1e6 << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <cstdlib>
+#include "../src/converter.hpp"
+#include "../include/ParallelMatcher.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// speculative parallel DFA simulation against the sequential table walk,
+// for 1, 2, 4, ... threads up to the hardware thread count
+//
+// usage: bench_parallel [megabytes] [regex]
+//---------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    size_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 256;
+    string regex = argc > 2 ? argv[2] : "(a|b|c|d)*.a.b.c";
+
+    DFA dfa = regexToDFA(regex);
+    const CompiledDFA &table = dfa.getCompiled();
+
+    string text(megabytes << 20, 'a');
+    mt19937 rng(42);
+    for (char &c : text)
+        c = "abcd"[rng() & 3];
+
+    auto Time = [](auto &&body) {
+        double best = 1e300;
+        for (int run = 0; run < 3; run++)
+        {
+            auto begin = chrono::steady_clock::now();
+            body();
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - begin).count());
+        }
+        return best;
+    };
+
+    bool expected = false;
+    double sequential = Time([&]() { expected = table.matches(text); });
+    cout << regex << ": " << table.NumStates() << " DFA states, " << megabytes << " MiB" << endl;
+    cout << left << setw(10) << "threads" << right << setw(12) << "MB/s" << setw(10) << "speedup" << endl;
+    cout << left << setw(10) << "seq" << right << setw(12) << fixed << setprecision(0)
+         << text.size() / sequential / 1e6 << setw(10) << setprecision(2) << 1.0 << endl;
+
+    size_t maxThreads = max(1u, thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ThreadPool pool(threads);
+        ParallelMatcher matcher(table, pool);
+        bool result = false;
+        double seconds = Time([&]() { result = matcher.matches(text); });
+        if (result != expected)
+        {
+            cerr << "mismatch with the sequential result" << endl;
+            return 1;
+        }
+        cout << left << setw(10) << threads << right << setw(12) << setprecision(0)
+             << text.size() / seconds / 1e6 << setw(10) << setprecision(2) << sequential / seconds << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "../src/converter.hpp"
+#include "../src/json_export.hpp"
+#include "../include/AllocTracker.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// the regex -> NFA -> DFA pipeline stage by stage on generated pattern
+// families, plus DFA::Move throughput. every stage reports its time, a rate
+// (regex bytes/s, states/s or input bytes/s) and its peak heap use. dfa-par
+// is the subset construction spread over one thread per core, the -dag
+// stages run on the hash-consed expression DAG and dfa-eps is the subset
+// construction on the NFA left by the epsilon stage. -json builds the
+// nlohmann tree and dumps it, -stream writes the same text straight from the
+// automaton and dfa-compact writes integer ids without whitespace
+//
+// usage: bench_pipeline [--quick] [--csv] [family]
+//---------------------------------------------------------------------------------
+
+// a.b.c.a.b.c...  n symbols
+static string Concat(size_t n)
+{
+    string regex = "a";
+    for (size_t i = 1; i < n; i++)
+    {
+        regex += '.';
+        regex += "abc"[i % 3];
+    }
+    return regex;
+}
+
+// (a|(b|(c|(a|...))))  n symbols, nested n - 1 deep
+static string DeepAlternation(size_t n)
+{
+    string regex;
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        regex += '(';
+        regex += "abc"[i % 3];
+        regex += '|';
+    }
+    regex += "abc"[(n - 1) % 3];
+    regex += string(n - 1, ')');
+    return regex;
+}
+
+// ((((a)*.b)*.c)*.a)*...  n stars nested
+static string NestedStars(size_t n)
+{
+    string regex = string(n, '(') + "a";
+    for (size_t i = 0; i < n; i++)
+    {
+        regex += ")*";
+        if (i + 1 < n)
+        {
+            regex += '.';
+            regex += "abc"[(i + 1) % 3];
+        }
+    }
+    return regex;
+}
+
+// (a|b)*.a.(a|b).(a|b)...  the n-th symbol from the end is an a: 2^(n+1) DFA states
+static string Blowup(size_t n)
+{
+    string regex = "(a|b)*.a";
+    for (size_t i = 0; i < n; i++)
+        regex += ".(a|b)";
+    return regex;
+}
+
+// (a|b|c).(a|b|c)...  one character class repeated n times, shared by the expression DAG
+static string RepeatedClass(size_t n)
+{
+    const string cls = "(a|b|c)";
+    string regex = cls;
+    for (size_t i = 1; i < n; i++)
+        regex += "." + cls;
+    return regex;
+}
+
+// counts the bytes written and drops them, a file without the disk
+class CountingBuffer : public streambuf
+{
+public:
+    size_t bytes = 0;
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        bytes++;
+        return traits_type::not_eof(c);
+    }
+    streamsize xsputn(const char *, streamsize n) override
+    {
+        bytes += n;
+        return n;
+    }
+};
+
+// bytes a streaming export writes
+template <typename Write>
+static size_t StreamedBytes(int indent, Write &&write)
+{
+    CountingBuffer counter;
+    ostream out(&counter);
+    {
+        JsonWriter writer(out, indent);
+        write(writer);
+    }
+    return counter.bytes;
+}
+
+struct Family
+{
+    const char *name;
+    string (*make)(size_t);
+    vector<size_t> sizes;
+    vector<size_t> quickSizes;
+};
+
+struct Measurement
+{
+    double seconds;
+    size_t peakBytes;
+};
+
+// best of runs, peak heap of the first run
+template <typename Body>
+static Measurement Measure(int runs, Body &&body)
+{
+    Measurement result{1e300, 0};
+    for (int run = 0; run < runs; run++)
+    {
+        AllocScope scope;
+        auto begin = chrono::steady_clock::now();
+        body();
+        result.seconds = min(result.seconds, chrono::duration<double>(chrono::steady_clock::now() - begin).count());
+        if (run == 0)
+            result.peakBytes = scope.PeakBytes();
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    bool quick = false, csv = false;
+    string only;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--quick"))
+            quick = true;
+        else if (!strcmp(argv[i], "--csv"))
+            csv = true;
+        else
+            only = argv[i];
+    }
+    int runs = quick ? 1 : 3;
+    ThreadPool pool; // one thread per core for the parallel subset construction
+    const size_t moveBytes = quick ? (1 << 18) : (4 << 20);
+
+    vector<Family> families = {
+        {"concat", Concat, {1000, 3000, 10000}, {1000, 3000}},
+        {"alternation", DeepAlternation, {100, 1000, 3000}, {100, 1000}},
+        {"nested-stars", NestedStars, {10, 100, 1000}, {10, 100}},
+        {"blowup", Blowup, {4, 8, 12, 14}, {4, 8}},
+        {"repeated", RepeatedClass, {300, 1000, 3000}, {300, 1000}},
+    };
+
+    if (!AllocTracker::Enabled())
+        cerr << "note: built without TRACK_ALLOCATIONS, peak memory reads 0" << endl;
+    if (csv)
+        cout << "family,size,stage,ms,rate,unit,peak_bytes" << endl;
+    else
+        cout << left << setw(14) << "family" << right << setw(8) << "size" << "  " << left << setw(12) << "stage"
+             << right << setw(12) << "ms" << setw(14) << "rate" << "  " << left << setw(10) << "unit" << right
+             << setw(12) << "peak KiB" << endl;
+
+    auto Report = [&](const Family &family, size_t size, const char *stage, const Measurement &m, double amount,
+                      const char *unit) {
+        double rate = m.seconds > 0 ? amount / m.seconds : 0;
+        if (csv)
+        {
+            cout << family.name << "," << size << "," << stage << "," << m.seconds * 1e3 << "," << rate << ","
+                 << unit << "," << m.peakBytes << endl;
+            return;
+        }
+        cout << left << setw(14) << family.name << right << setw(8) << size << "  " << left << setw(12) << stage
+             << right << setw(12) << fixed << setprecision(3) << m.seconds * 1e3 << setw(14) << setprecision(0)
+             << rate << "  " << left << setw(10) << unit << right << setw(12) << setprecision(1)
+             << m.peakBytes / 1024.0 << endl;
+    };
+
+    for (const Family &family : families)
+    {
+        if (!only.empty() && only != family.name)
+            continue;
+        for (size_t size : quick ? family.quickSizes : family.sizes)
+        {
+            string regex = family.make(size);
+
+            string postfix;
+            Measurement m = Measure(runs, [&]() { postfix = InfixToPostfix(regex); });
+            Report(family, size, "postfix", m, regex.size(), "bytes/s");
+
+            NFA nfa = PostfixToNFA(postfix);
+            m = Measure(runs, [&]() { nfa = PostfixToNFA(postfix); });
+            Report(family, size, "nfa", m, nfa.NumStates(), "states/s");
+            m = Measure(runs, [&]() { nfa = DAGToNFA(RegexDAG::FromPostfix(postfix)); });
+            Report(family, size, "nfa-dag", m, nfa.NumStates(), "states/s");
+            m = Measure(runs, [&]() { Prefilter::FromPostfix(postfix); });
+            Report(family, size, "prefix", m, regex.size(), "bytes/s");
+            m = Measure(runs, [&]() { Prefilter::FromDAG(RegexDAG::FromPostfix(postfix)); });
+            Report(family, size, "prefix-dag", m, regex.size(), "bytes/s");
+
+            DFA dfa;
+            m = Measure(runs, [&]() { dfa = NFAtoDFA(nfa); });
+            size_t dfaStates = dfa.getCompiled().NumStates();
+            Report(family, size, "dfa", m, dfaStates, "states/s");
+            m = Measure(runs, [&]() { dfa = NFAtoDFAParallel(nfa, pool); });
+            Report(family, size, "dfa-par", m, dfaStates, "states/s");
+
+            NFA epsFree = RemoveEpsilons(nfa, nullptr, EpsilonEdgeBudget(nfa));
+            m = Measure(runs, [&]() { epsFree = RemoveEpsilons(nfa, nullptr, EpsilonEdgeBudget(nfa)); });
+            Report(family, size, "epsilon", m, nfa.NumStates(), "states/s");
+            DFA epsFreeDFA;
+            m = Measure(runs, [&]() { epsFreeDFA = NFAtoDFA(epsFree); });
+            Report(family, size, "dfa-eps", m, epsFreeDFA.getCompiled().NumStates(), "states/s");
+
+            size_t jsonBytes = 0; // keeps the dumps observable
+            m = Measure(runs, [&]() { jsonBytes = nfaToJson(nfa).dump(2).size(); });
+            Report(family, size, "nfa-json", m, nfa.NumStates(), "states/s");
+            m = Measure(runs, [&]() { jsonBytes = dfaToJson(dfa).dump(2).size(); });
+            Report(family, size, "dfa-json", m, dfaStates, "states/s");
+            m = Measure(runs, [&]() {
+                jsonBytes = StreamedBytes(2, [&](JsonWriter &w) { writeNfaJson(w, nfa, JsonStyle::PRETTY); });
+            });
+            Report(family, size, "nfa-stream", m, nfa.NumStates(), "states/s");
+            m = Measure(runs, [&]() {
+                jsonBytes = StreamedBytes(2, [&](JsonWriter &w) { writeDfaJson(w, dfa, JsonStyle::PRETTY); });
+            });
+            Report(family, size, "dfa-stream", m, dfaStates, "states/s");
+            m = Measure(runs, [&]() {
+                jsonBytes = StreamedBytes(-1, [&](JsonWriter &w) { writeDfaJson(w, dfa, JsonStyle::COMPACT); });
+            });
+            Report(family, size, "dfa-compact", m, dfaStates, "states/s");
+
+            // Move over random text in the alphabet, restarting whenever the DFA dies
+            string text(moveBytes, 'a');
+            mt19937 rng(size);
+            for (char &c : text)
+                c = "abc"[rng() % 3];
+            size_t accepts = 0;
+            m = Measure(runs, [&]() {
+                dfa.Reset();
+                for (char c : text)
+                {
+                    dfa.Move(c);
+                    if (dfa.GetStatus() == ACCEPT)
+                        accepts++;
+                    else if (dfa.IsDead())
+                        dfa.Reset();
+                }
+            });
+            Report(family, size, "move", m, text.size(), "bytes/s");
+            (void)jsonBytes;
+            (void)accepts;
+        }
+    }
+    return 0;
+}
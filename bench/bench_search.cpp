@@ -0,0 +1,67 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// find_all throughput with and without the literal/first-byte prefilter on
+// random lowercase text
+//
+// usage: bench_search [megabytes]
+//---------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    size_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 64;
+
+    string text(megabytes << 20, 'a');
+    mt19937 rng(42);
+    for (char &c : text)
+        c = 'a' + rng() % 26;
+
+    auto Time = [](auto &&body) {
+        double best = 1e300;
+        for (int run = 0; run < 3; run++)
+        {
+            auto begin = chrono::steady_clock::now();
+            body();
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - begin).count());
+        }
+        return best;
+    };
+
+    vector<string> regexes = {"q.u.i.c.k.(x|y)*", "z.(a|b)", "(x|y|z).q", "(a|e|i|o|u).(b|c)*.z"};
+    cout << "scan kernel: " << Prefilter::Kernel() << ", " << megabytes << " MiB" << endl;
+    cout << left << setw(24) << "regex" << setw(10) << "literal" << right << setw(8) << "first"
+         << setw(12) << "plain MB/s" << setw(14) << "filtered MB/s" << setw(10) << "speedup" << endl;
+
+    for (const string &regex : regexes)
+    {
+        DFA dfa = regexToDFA(regex);
+        CompiledDFA filtered = dfa.getCompiled();
+        CompiledDFA plain = filtered;
+        plain.setPrefilter(Prefilter());
+
+        size_t plainCount = 0, filteredCount = 0;
+        auto Ignore = [](size_t, size_t) {};
+        double plainSec = Time([&]() { plainCount = plain.find_all(text, Ignore); });
+        double filteredSec = Time([&]() { filteredCount = filtered.find_all(text, Ignore); });
+        if (plainCount != filteredCount)
+        {
+            cerr << regex << ": " << filteredCount << " matches with the prefilter, " << plainCount << " without" << endl;
+            return 1;
+        }
+
+        const Prefilter &prefilter = filtered.getPrefilter();
+        cout << left << setw(24) << regex << setw(10) << prefilter.Literal() << right << setw(8)
+             << prefilter.NumFirstBytes() << setw(12) << fixed << setprecision(0) << text.size() / plainSec / 1e6
+             << setw(14) << text.size() / filteredSec / 1e6 << setw(10) << setprecision(2)
+             << plainSec / filteredSec << endl;
+    }
+    return 0;
+}
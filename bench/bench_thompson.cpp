@@ -0,0 +1,99 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// Thompson construction scaling: InfixToPostfix + PostfixToNFA on regexes of
+// 1k to 1M characters. linear construction shows a flat ns/char column
+//
+// usage: bench_thompson [max_chars]
+//---------------------------------------------------------------------------------
+
+// a.b.c.a.b.c...
+static string LongConcat(size_t chars)
+{
+    string regex = "a";
+    for (size_t i = 1; regex.size() + 2 <= chars; i++)
+    {
+        regex += '.';
+        regex += "abc"[i % 3];
+    }
+    return regex;
+}
+
+// a|b|c|a|b|c...
+static string LongAlternation(size_t chars)
+{
+    string regex = "a";
+    for (size_t i = 1; regex.size() + 2 <= chars; i++)
+    {
+        regex += '|';
+        regex += "abc"[i % 3];
+    }
+    return regex;
+}
+
+// (a.b)*.(c|a)*.(b.c)*...
+static string StarChain(size_t chars)
+{
+    const char *pieces[] = {"(a.b)*", "(c|a)*", "(b.c)*"};
+    string regex = pieces[0];
+    for (size_t i = 1; regex.size() + 7 <= chars; i++)
+    {
+        regex += '.';
+        regex += pieces[i % 3];
+    }
+    return regex;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxChars = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    struct Family
+    {
+        const char *name;
+        string (*make)(size_t);
+    };
+    vector<Family> families = {
+        {"concat", LongConcat},
+        {"alternation", LongAlternation},
+        {"star-chain", StarChain},
+    };
+
+    cout << left << setw(12) << "family" << right << setw(10) << "chars" << setw(10) << "states"
+         << setw(10) << "edges" << setw(12) << "ms" << setw(12) << "ns/char" << endl;
+
+    for (const Family &family : families)
+    {
+        for (size_t chars = 1000; chars <= maxChars; chars *= 10)
+        {
+            string regex = family.make(chars);
+
+            // best of three runs
+            double bestMs = 1e300;
+            size_t states = 0, edges = 0;
+            for (int run = 0; run < 3; run++)
+            {
+                auto begin = chrono::steady_clock::now();
+                NFA nfa = PostfixToNFA(InfixToPostfix(regex));
+                auto end = chrono::steady_clock::now();
+                bestMs = min(bestMs, chrono::duration<double, milli>(end - begin).count());
+                states = nfa.getArena().NumStates();
+                edges = nfa.getArena().edges.size();
+            }
+
+            cout << left << setw(12) << family.name << right << setw(10) << regex.size()
+                 << setw(10) << states << setw(10) << edges << setw(12) << fixed << setprecision(3)
+                 << bestMs << setw(12) << setprecision(1) << bestMs * 1e6 / regex.size() << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+# regex_generate_header(<output> REGEX <regex> NAMESPACE <name> [STYLE table|switch])
+#
+# Compiles REGEX at build time and writes it to <output> as a self-contained
+# C++ header with match() and longest_match() in namespace NAMESPACE. The
+# header is regenerated whenever the generator is rebuilt. Add
+# <output> to a target's sources so it is generated before that target builds.
+function(regex_generate_header output)
+    cmake_parse_arguments(ARG "" "REGEX;NAMESPACE;STYLE" "" ${ARGN})
+    if(NOT ARG_REGEX OR NOT ARG_NAMESPACE)
+        message(FATAL_ERROR "regex_generate_header: REGEX and NAMESPACE are required")
+    endif()
+    if(NOT ARG_STYLE)
+        set(ARG_STYLE switch)
+    endif()
+
+    get_filename_component(output_dir ${output} DIRECTORY)
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+        COMMAND state_machine_visualizer --emit-cpp "${ARG_REGEX}" ${output}
+                --name ${ARG_NAMESPACE} --style ${ARG_STYLE}
+        DEPENDS state_machine_visualizer
+        COMMENT "Generating ${ARG_NAMESPACE} from ${ARG_REGEX}"
+        VERBATIM
+    )
+endfunction()
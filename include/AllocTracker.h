@@ -0,0 +1,40 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <cstddef>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class AllocTracker
+// process-wide heap accounting through replaced global operator new/delete.
+// only the benchmarks link it in (with -DTRACK_ALLOCATIONS=ON, the default).
+// everywhere else Enabled() is false and every counter reads 0
+//---------------------------------------------------------------------------------
+class AllocTracker
+{
+public:
+    static bool Enabled();
+    static size_t CurrentBytes();  // live bytes allocated with operator new
+    static size_t PeakBytes();     // high-water mark since the last ResetPeak
+    static size_t Allocations();   // operator new calls so far
+    static void ResetPeak();       // restart the high-water mark at CurrentBytes
+};
+
+// peak bytes allocated on top of what was live at construction, e.g. by
+// one pipeline stage. scopes must not overlap
+class AllocScope
+{
+public:
+    AllocScope() : base(AllocTracker::CurrentBytes()) { AllocTracker::ResetPeak(); }
+    size_t PeakBytes() const
+    {
+        size_t peak = AllocTracker::PeakBytes();
+        return peak > base ? peak - base : 0;
+    }
+
+private:
+    size_t base;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef COMPILELIMITS_H
+#define COMPILELIMITS_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// bounds on one subset construction, 0 means unlimited
+struct CompileLimits
+{
+    size_t max_states = 0; // DFA states
+    size_t max_bytes = 0;  // estimated working memory: state sets, lookup map and rows
+    double max_ms = 0;     // wall-clock time
+
+    bool Unlimited() const { return max_states == 0 && max_bytes == 0 && max_ms == 0; }
+};
+
+enum class CompileLimit {STATES, MEMORY, TIME};
+
+//---------------------------------------------------------------------------------
+// class DFALimitExceeded
+// thrown by subset construction when a CompileLimits bound trips. everything
+// built so far is released, so the caller can fall back to a lazy engine
+//---------------------------------------------------------------------------------
+class DFALimitExceeded : public runtime_error
+{
+public:
+    DFALimitExceeded(CompileLimit which, size_t states, size_t bytes, double ms)
+        : runtime_error(Describe(which, states, bytes, ms)), limit(which), states(states), bytes(bytes), ms(ms)
+    {
+    }
+
+    CompileLimit Limit() const { return limit; }
+    size_t States() const { return states; } // DFA states built when it tripped
+    size_t Bytes() const { return bytes; }
+    double Milliseconds() const { return ms; }
+
+private:
+    static string Describe(CompileLimit which, size_t states, size_t bytes, double ms)
+    {
+        const char *names[] = {"state", "memory", "time"};
+        return string("DFA ") + names[(int)which] + " limit exceeded after " + to_string(states) + " states, " +
+               to_string(bytes) + " bytes, " + to_string((long long)ms) + " ms";
+    }
+
+    CompileLimit limit;
+    size_t states;
+    size_t bytes;
+    double ms;
+};
+
+#endif
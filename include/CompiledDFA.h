@@ -0,0 +1,94 @@
+#ifndef COMPILEDDFA_H
+#define COMPILEDDFA_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <set>
+#include <map>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include "MatchLoops.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class CompiledDFA
+// flat matching form of a DFA: dense state ids 0..n-1, the 256 input bytes
+// compressed into byte classes, and one contiguous uint32_t transition table
+// indexed by state * width + class. missing transitions hold DEAD.
+// the arrays are either owned or a view into memory kept alive by a
+// backing object, e.g. a mapped DFA file (see DFAFile.h)
+//---------------------------------------------------------------------------------
+class CompiledDFA
+{
+public:
+    static constexpr uint32_t DEAD = 0xFFFFFFFFu;
+
+    CompiledDFA();
+    // build from the map form, renumbering states densely in ascending id order
+    CompiledDFA(const map<int, map<char, int>> &Dtran, int start, const set<int> &finals);
+    // build from dense rows: rows[s][i] is the target of state s on symbols[i] (-1 if none).
+    // tags[s] is the pattern accepted in state s, -1 if s is not accepting
+    CompiledDFA(const vector<char> &symbols, const vector<vector<int>> &rows,
+                const vector<int> &tags, int start);
+    // view over arrays stored elsewhere, backing keeps them alive. states keep their ids
+    CompiledDFA(uint32_t states, uint32_t classes, uint32_t start, const uint8_t *byteClasses,
+                const uint32_t *transitions, const uint64_t *acceptBits, const int *acceptTags,
+                shared_ptr<const void> backing);
+
+    CompiledDFA(const CompiledDFA &other);
+    CompiledDFA &operator=(const CompiledDFA &other);
+    CompiledDFA(CompiledDFA &&) = default;
+    CompiledDFA &operator=(CompiledDFA &&) = default;
+
+    uint32_t Start() const { return start_state; }
+    uint32_t Next(uint32_t state, unsigned char c) const { return table[state * width + byte_class[c]]; }
+    bool IsAccepting(uint32_t state) const { return (accept_bits[state >> 6] >> (state & 63)) & 1; }
+    int AcceptTag(uint32_t state) const { return accept_tags[state]; }
+
+    size_t NumStates() const { return num_states; }
+    size_t AlphabetWidth() const { return width; }
+    const uint8_t *ByteClasses() const { return byte_class.data(); }
+    const uint32_t *Table() const { return table; }
+    const uint64_t *AcceptBits() const { return accept_bits; }
+    const int *AcceptTags() const { return accept_tags; }
+    size_t MemoryBytes() const;
+
+    // buffer-level matching, no per-byte allocation
+    size_t LongestMatch(string_view text, size_t pos) const;
+    bool matches(string_view text) const;
+    bool search(string_view text, MatchSpan &match) const;
+    size_t find_all(string_view text, const function<void(size_t, size_t)> &callback) const;
+
+    // candidate skipping for search and find_all, see Prefilter
+    void setPrefilter(const Prefilter &newPrefilter) { prefilter = newPrefilter; }
+    const Prefilter &getPrefilter() const { return prefilter; }
+
+    int OriginalId(uint32_t state) const { return original_ids.empty() ? (int)state : original_ids[state]; }
+    uint32_t DenseId(int original) const;
+    map<int, map<char, int>> ToMap() const;
+
+private:
+    void Build(const vector<char> &symbols, const vector<vector<uint32_t>> &columns,
+               const vector<int> &tags);
+    void Attach();
+
+    uint32_t num_states;
+    uint32_t width;                 // number of byte classes
+    uint32_t start_state;
+    array<uint8_t, 256> byte_class; // byte -> class
+    const uint32_t *table;          // num_states * width
+    const uint64_t *accept_bits;    // one bit per state
+    const int *accept_tags;         // pattern id per state, -1 if not accepting
+    vector<uint32_t> own_table;     // storage behind the views unless backing is set
+    vector<uint64_t> own_accept_bits;
+    vector<int> own_accept_tags;
+    shared_ptr<const void> backing;
+    vector<int> original_ids;       // dense id -> id in the map form, empty if they are the same
+    Prefilter prefilter;            // disabled unless the pattern was analyzed
+};
+
+#endif
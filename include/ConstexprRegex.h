@@ -0,0 +1,416 @@
+#ifndef CONSTEXPRREGEX_H
+#define CONSTEXPRREGEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <string_view>
+#include <stdexcept>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// struct StaticDFA
+// a minimized DFA in fixed-capacity arrays, produced by compile_regex. every
+// operand symbol has its own byte class; class 0 (all other bytes) has no
+// transitions. rows have a fixed stride so the matching loop can be
+// specialized for the pattern when the DFA is a constant
+//---------------------------------------------------------------------------------
+template <size_t MaxStates>
+struct StaticDFA
+{
+    static constexpr size_t MAX_CLASSES = 64; // 52 letters and class 0
+    static constexpr uint16_t DEAD = 0xFFFF;
+
+    size_t num_states = 0;
+    size_t width = 1; // byte classes in use
+    uint16_t start_state = 0;
+    array<uint8_t, 256> byte_class{};
+    array<uint16_t, MaxStates * MAX_CLASSES> table{};
+    array<bool, MaxStates> accepting{};
+
+    constexpr size_t NumStates() const { return num_states; }
+    constexpr uint16_t Start() const { return start_state; }
+    constexpr uint16_t Next(uint16_t state, unsigned char c) const { return table[state * MAX_CLASSES + byte_class[c]]; }
+    constexpr bool IsAccepting(uint16_t state) const { return accepting[state]; }
+
+    // does the whole of text match
+    constexpr bool matches(string_view text) const
+    {
+        uint16_t state = start_state;
+        for (char c : text)
+        {
+            state = Next(state, c);
+            if (state == DEAD)
+                return false;
+        }
+        return accepting[state];
+    }
+
+    // end of the longest match anchored at pos, string_view::npos if there is none
+    constexpr size_t LongestMatch(string_view text, size_t pos = 0) const
+    {
+        uint16_t state = start_state;
+        size_t last = accepting[state] ? pos : string_view::npos;
+        for (size_t i = pos; i < text.size(); i++)
+        {
+            state = Next(state, text[i]);
+            if (state == DEAD)
+                break;
+            if (accepting[state])
+                last = i + 1;
+        }
+        return last;
+    }
+};
+
+//---------------------------------------------------------------------------------
+// class ConstexprRegexCompiler
+// InfixToPostfix -> Thompson construction -> subset construction ->
+// minimization, all constexpr over fixed-capacity arrays. the steps follow
+// converter.cpp; errors throw, which makes a constant evaluation ill-formed
+// and so surface as compile errors. MaxNFA bounds the NFA states (two per
+// operand, star and alternation) and the length of the postfix
+//---------------------------------------------------------------------------------
+template <size_t MaxStates, size_t MaxNFA>
+class ConstexprRegexCompiler
+{
+public:
+    static_assert(MaxStates > 0 && MaxStates < StaticDFA<MaxStates>::DEAD, "MaxStates must fit in uint16_t");
+    static_assert(MaxNFA > 0 && MaxNFA < 0xFFFF, "MaxNFA must fit in uint16_t");
+
+    static constexpr StaticDFA<MaxStates> Compile(string_view infix)
+    {
+        return Minimize(NFAtoDFA(PostfixToNFA(InfixToPostfix(infix))));
+    }
+
+private:
+    static constexpr char EPSILON = '_';
+    static constexpr size_t WORDS = (MaxNFA + 63) / 64;
+
+    struct Postfix
+    {
+        array<char, MaxNFA> chars{};
+        size_t size = 0;
+    };
+
+    struct Edge
+    {
+        uint16_t dst = 0;
+        char sym = 0;
+    };
+
+    // Thompson NFAs have at most two edges leaving any state
+    struct NFA
+    {
+        array<array<Edge, 2>, MaxNFA> edges{};
+        array<uint8_t, MaxNFA> numEdges{};
+        size_t numStates = 0;
+        uint16_t start = 0;
+        uint16_t final = 0;
+
+        constexpr uint16_t AddState()
+        {
+            if (numStates == MaxNFA)
+                throw length_error("compile_regex: NFA has more than MaxNFA states");
+            return numStates++;
+        }
+        constexpr void AddEdge(uint16_t src, uint16_t dst, char sym)
+        {
+            edges[src][numEdges[src]++] = Edge{dst, sym};
+        }
+    };
+
+    struct Set
+    {
+        array<uint64_t, WORDS> words{};
+
+        constexpr void Insert(size_t s) { words[s >> 6] |= uint64_t(1) << (s & 63); }
+        constexpr bool Contains(size_t s) const { return (words[s >> 6] >> (s & 63)) & 1; }
+        constexpr bool Empty() const
+        {
+            for (uint64_t w : words)
+                if (w)
+                    return false;
+            return true;
+        }
+        constexpr bool operator==(const Set &other) const
+        {
+            for (size_t i = 0; i < WORDS; i++)
+                if (words[i] != other.words[i])
+                    return false;
+            return true;
+        }
+    };
+
+    static constexpr bool IsOperand(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+    static constexpr int Precedence(char op)
+    {
+        if (op == '*')
+            return 3;
+        if (op == '.')
+            return 2;
+        if (op == '|')
+            return 1;
+        return 0;
+    }
+
+    //---- shunting-yard, as InfixToPostfix
+    static constexpr Postfix InfixToPostfix(string_view infix)
+    {
+        Postfix postfix;
+        array<char, MaxNFA> ops{};
+        size_t numOps = 0;
+        auto Emit = [&](char c) {
+            if (postfix.size == MaxNFA)
+                throw length_error("compile_regex: regex is longer than MaxNFA");
+            postfix.chars[postfix.size++] = c;
+        };
+        auto Push = [&](char c) {
+            if (numOps == MaxNFA)
+                throw length_error("compile_regex: regex is longer than MaxNFA");
+            ops[numOps++] = c;
+        };
+
+        for (char c : infix)
+        {
+            if (IsOperand(c))
+                Emit(c);
+            else if (c == '(' || c == '*')
+                Push(c);
+            else if (c == ')')
+            {
+                while (numOps > 0 && ops[numOps - 1] != '(')
+                    Emit(ops[--numOps]);
+                if (numOps == 0)
+                    throw invalid_argument("compile_regex: unbalanced parentheses");
+                numOps--;
+            }
+            else if (c == '|' || c == '.')
+            {
+                while (numOps > 0 && ops[numOps - 1] != '(' && Precedence(ops[numOps - 1]) >= Precedence(c))
+                    Emit(ops[--numOps]);
+                Push(c);
+            }
+        }
+        while (numOps > 0)
+        {
+            if (ops[numOps - 1] == '(')
+                throw invalid_argument("compile_regex: unbalanced parentheses");
+            Emit(ops[--numOps]);
+        }
+        return postfix;
+    }
+
+    //---- Thompson's construction, as NFABuilder
+    static constexpr NFA PostfixToNFA(const Postfix &postfix)
+    {
+        NFA nfa;
+        array<uint16_t, MaxNFA> starts{};
+        array<uint16_t, MaxNFA> ends{};
+        size_t depth = 0;
+
+        for (size_t i = 0; i < postfix.size; i++)
+        {
+            char c = postfix.chars[i];
+            if (IsOperand(c))
+            {
+                uint16_t start = nfa.AddState();
+                uint16_t end = nfa.AddState();
+                nfa.AddEdge(start, end, c);
+                starts[depth] = start;
+                ends[depth++] = end;
+                continue;
+            }
+            if (c != '*' && c != '.' && c != '|')
+                continue;
+            if (depth < (c == '*' ? 1u : 2u))
+                throw invalid_argument("compile_regex: operator is missing an operand");
+
+            if (c == '*')
+            {
+                uint16_t start = nfa.AddState();
+                uint16_t end = nfa.AddState();
+                nfa.AddEdge(start, starts[depth - 1], EPSILON);
+                nfa.AddEdge(start, end, EPSILON);
+                nfa.AddEdge(ends[depth - 1], starts[depth - 1], EPSILON);
+                nfa.AddEdge(ends[depth - 1], end, EPSILON);
+                starts[depth - 1] = start;
+                ends[depth - 1] = end;
+            }
+            else if (c == '.')
+            {
+                nfa.AddEdge(ends[depth - 2], starts[depth - 1], EPSILON);
+                ends[depth - 2] = ends[depth - 1];
+                depth--;
+            }
+            else
+            {
+                uint16_t start = nfa.AddState();
+                uint16_t end = nfa.AddState();
+                nfa.AddEdge(start, starts[depth - 2], EPSILON);
+                nfa.AddEdge(start, starts[depth - 1], EPSILON);
+                nfa.AddEdge(ends[depth - 2], end, EPSILON);
+                nfa.AddEdge(ends[depth - 1], end, EPSILON);
+                starts[depth - 2] = start;
+                ends[depth - 2] = end;
+                depth--;
+            }
+        }
+        if (depth != 1)
+            throw invalid_argument(depth == 0 ? "compile_regex: no operands"
+                                              : "compile_regex: operands without an operator");
+        nfa.start = starts[0];
+        nfa.final = ends[0];
+        return nfa;
+    }
+
+    static constexpr void EpsilonClosure(const NFA &nfa, Set &set)
+    {
+        array<uint16_t, MaxNFA> stack{};
+        size_t top = 0;
+        for (size_t s = 0; s < nfa.numStates; s++)
+            if (set.Contains(s))
+                stack[top++] = s;
+        while (top > 0)
+        {
+            uint16_t s = stack[--top];
+            for (size_t e = 0; e < nfa.numEdges[s]; e++)
+            {
+                const Edge &edge = nfa.edges[s][e];
+                if (edge.sym == EPSILON && !set.Contains(edge.dst))
+                {
+                    set.Insert(edge.dst);
+                    stack[top++] = edge.dst;
+                }
+            }
+        }
+    }
+
+    //---- subset construction, states numbered in discovery order
+    static constexpr StaticDFA<MaxStates> NFAtoDFA(const NFA &nfa)
+    {
+        StaticDFA<MaxStates> dfa;
+        array<char, StaticDFA<MaxStates>::MAX_CLASSES> symbols{};
+        for (size_t s = 0; s < nfa.numStates; s++)
+        {
+            for (size_t e = 0; e < nfa.numEdges[s]; e++)
+            {
+                unsigned char sym = nfa.edges[s][e].sym;
+                if (sym != EPSILON && dfa.byte_class[sym] == 0)
+                {
+                    symbols[dfa.width] = sym;
+                    dfa.byte_class[sym] = dfa.width++;
+                }
+            }
+        }
+
+        array<Set, MaxStates> sets{};
+        sets[0].Insert(nfa.start);
+        EpsilonClosure(nfa, sets[0]);
+        dfa.num_states = 1;
+        for (size_t i = 0; i < MaxStates * StaticDFA<MaxStates>::MAX_CLASSES; i++)
+            dfa.table[i] = StaticDFA<MaxStates>::DEAD;
+
+        for (size_t d = 0; d < dfa.num_states; d++)
+        {
+            for (size_t cls = 1; cls < dfa.width; cls++)
+            {
+                Set next;
+                for (size_t s = 0; s < nfa.numStates; s++)
+                    if (sets[d].Contains(s))
+                        for (size_t e = 0; e < nfa.numEdges[s]; e++)
+                            if (nfa.edges[s][e].sym == symbols[cls])
+                                next.Insert(nfa.edges[s][e].dst);
+                if (next.Empty())
+                    continue;
+                EpsilonClosure(nfa, next);
+
+                size_t found = 0;
+                while (found < dfa.num_states && !(sets[found] == next))
+                    found++;
+                if (found == dfa.num_states)
+                {
+                    if (found == MaxStates)
+                        throw length_error("compile_regex: DFA has more than MaxStates states");
+                    sets[dfa.num_states++] = next;
+                }
+                dfa.table[d * StaticDFA<MaxStates>::MAX_CLASSES + cls] = found;
+            }
+            dfa.accepting[d] = sets[d].Contains(nfa.final);
+        }
+        return dfa;
+    }
+
+    //---- Moore partition refinement. blocks are numbered by their first
+    // state, so the start state stays 0
+    static constexpr StaticDFA<MaxStates> Minimize(const StaticDFA<MaxStates> &dfa)
+    {
+        constexpr size_t STRIDE = StaticDFA<MaxStates>::MAX_CLASSES;
+        constexpr uint16_t DEAD = StaticDFA<MaxStates>::DEAD;
+        array<uint16_t, MaxStates> block{};
+        size_t numBlocks = 0;
+        auto SameSignature = [&](size_t a, size_t b, const array<uint16_t, MaxStates> &current) {
+            if (current[a] != current[b])
+                return false;
+            for (size_t cls = 1; cls < dfa.width; cls++)
+            {
+                uint16_t ta = dfa.table[a * STRIDE + cls];
+                uint16_t tb = dfa.table[b * STRIDE + cls];
+                if ((ta == DEAD) != (tb == DEAD) || (ta != DEAD && current[ta] != current[tb]))
+                    return false;
+            }
+            return true;
+        };
+
+        for (size_t s = 0; s < dfa.num_states; s++)
+            block[s] = dfa.accepting[s] ? 1 : 0;
+        for (;;)
+        {
+            array<uint16_t, MaxStates> refined{};
+            size_t count = 0;
+            for (size_t s = 0; s < dfa.num_states; s++)
+            {
+                size_t rep = 0;
+                while (rep < s && !SameSignature(rep, s, block))
+                    rep++;
+                refined[s] = (rep < s) ? refined[rep] : count++;
+            }
+            block = refined;
+            if (count == numBlocks)
+                break;
+            numBlocks = count;
+        }
+
+        StaticDFA<MaxStates> result;
+        result.num_states = numBlocks;
+        result.width = dfa.width;
+        result.byte_class = dfa.byte_class;
+        for (size_t i = 0; i < MaxStates * STRIDE; i++)
+            result.table[i] = DEAD;
+        for (size_t s = 0; s < dfa.num_states; s++)
+        {
+            for (size_t cls = 1; cls < dfa.width; cls++)
+            {
+                uint16_t dst = dfa.table[s * STRIDE + cls];
+                result.table[block[s] * STRIDE + cls] = (dst == DEAD) ? DEAD : block[dst];
+            }
+            result.accepting[block[s]] = dfa.accepting[s];
+        }
+        return result;
+    }
+};
+
+//---------------------------------------------------------------------------------
+// compile a regex into a StaticDFA, usable in constant expressions:
+//   constexpr auto m = compile_regex("(a|b)*.c");
+//   static_assert(m.matches("abac"));
+//---------------------------------------------------------------------------------
+template <size_t MaxStates = 32, size_t MaxNFA = 128>
+constexpr StaticDFA<MaxStates> compile_regex(string_view infix)
+{
+    return ConstexprRegexCompiler<MaxStates, MaxNFA>::Compile(infix);
+}
+
+#endif
@@ -3,23 +3,36 @@
 
 #include <set>
 #include <map>
+#include <string>
+#include <memory>
+#include "CompiledDFA.h"
+#include "DFACursor.h"
 
 using namespace std;
 
-enum DFAstatus {START, FAIL, POTENTIAL, ACCEPT};
-
 //---------------------------------------------------------------------------------
 // class DFA
 // (S, Σ, δ, s0, F)
+// the compiled table is immutable and shared: copies of a DFA, Share() and
+// any number of DFACursors use it without copying
 //---------------------------------------------------------------------------------
 class DFA 
 {
 public:
-    DFA() {}
+    DFA() : table(make_shared<const CompiledDFA>()), status(START), current_state(0), accepted(false), compiled(false) {}
     DFA(set<char> A, set<int> I, set<int> F);
     void Reset();
-    void AddTransition( int src, int dst, char sym) {Dtran[src][sym] = dst;}
-    void setFinalStates ( const set<int> &newFinalStates) { fin_states = newFinalStates; }
+    void AddTransition( int src, int dst, char sym) {Dtran[src][sym] = dst; compiled = false;}
+    void setFinalStates ( const set<int> &newFinalStates) { fin_states = newFinalStates; compiled = false; }
+    void Compile();
+    void setCompiled(CompiledDFA newTable);
+    const CompiledDFA &getCompiled() { return *Share(); }
+    shared_ptr<const CompiledDFA> Share() { if (!compiled) Compile(); return table; }
+    void setPrefilter(const Prefilter &newPrefilter);
+    const Prefilter &getPrefilter() const { return prefilter; }
+    bool matches(string_view text) const;
+    bool search(string_view text, MatchSpan &match) const;
+    size_t find_all(string_view text, const function<void(size_t, size_t)> &callback) const;
     void Move( char c);
     DFAstatus GetStatus() {return status;}
     string GetAcceptedLexeme() {return accepted_lexeme;}
@@ -27,19 +40,26 @@ public:
     void Print();
     bool IsDead() const { return status == FAIL; }
     bool acceptsEmptyString() const;
-    map<int, map<char, int>> getDFATransitions() const { return Dtran; }
-    set<int> getInitStates() const { return init_states; }
-    set<int> getFinalStates() const { return fin_states; }
+    const map<int, map<char, int>> &getDFATransitions() const { return Dtran; }
+    size_t NumTransitions() const;
+    const set<int> &getInitStates() const { return init_states; }
+    const set<int> &getFinalStates() const { return fin_states; }
 
 private:
-    map< int, map<char, int> > Dtran;
+    void Install(shared_ptr<CompiledDFA> newTable);
+    shared_ptr<const CompiledDFA> Snapshot() const;
+
+    map< int, map<char, int> > Dtran; // map form, kept for JSON export
+    shared_ptr<const CompiledDFA> table; // flat form used for matching
     DFAstatus status;
-    int current_state;
+    uint32_t current_state;           // dense id in table
     bool accepted;
     string lexeme;
     string accepted_lexeme;
     set<int> init_states; // initial state of the DFA
     set<int> fin_states;  // final states of the DFA
+    bool compiled;        // table is up to date with Dtran
+    Prefilter prefilter;  // carried over to every table installed
 };
 
 #endif
\ No newline at end of file
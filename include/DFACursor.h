@@ -0,0 +1,75 @@
+#ifndef DFACURSOR_H
+#define DFACURSOR_H
+
+#include <cstdint>
+#include <string_view>
+#include "CompiledDFA.h"
+
+using namespace std;
+
+enum DFAstatus {START, FAIL, POTENTIAL, ACCEPT};
+
+//---------------------------------------------------------------------------------
+// class DFACursor
+// the mutable half of matching: a position in a CompiledDFA that is shared
+// and never modified. a cursor is a few words meant to live on the stack,
+// so any number of threads can walk one table at once
+//---------------------------------------------------------------------------------
+class DFACursor
+{
+public:
+    explicit DFACursor(const CompiledDFA &dfa) : table(&dfa) { Reset(); }
+
+    void Reset()
+    {
+        state = table->Start();
+        consumed = 0;
+        lastAccept = table->IsAccepting(state) ? 0 : NO_MATCH;
+    }
+
+    // consume one byte, false once the DFA is dead
+    bool Move(unsigned char c)
+    {
+        if (state == CompiledDFA::DEAD)
+            return false;
+        state = table->Next(state, c);
+        if (state == CompiledDFA::DEAD)
+            return false;
+        consumed++;
+        if (table->IsAccepting(state))
+            lastAccept = consumed;
+        return true;
+    }
+
+    // consume text until it ends or the DFA dies, false if it died
+    bool Feed(string_view text)
+    {
+        for (char c : text)
+            if (!Move(c))
+                return false;
+        return true;
+    }
+
+    bool IsDead() const { return state == CompiledDFA::DEAD; }
+    bool IsAccepting() const { return !IsDead() && table->IsAccepting(state); }
+    uint32_t State() const { return state; }
+    size_t Consumed() const { return consumed; }      // bytes consumed before dying
+    size_t LastAccept() const { return lastAccept; }  // length of the longest accepted prefix, NO_MATCH if none
+
+    DFAstatus Status() const
+    {
+        if (IsDead())
+            return FAIL;
+        if (table->IsAccepting(state))
+            return ACCEPT;
+        return consumed == 0 ? START : POTENTIAL;
+    }
+
+private:
+    const CompiledDFA *table;
+    uint32_t state;
+    size_t consumed;
+    size_t lastAccept;
+};
+
+#endif
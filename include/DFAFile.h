@@ -0,0 +1,53 @@
+#ifndef DFAFILE_H
+#define DFAFILE_H
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include "CompiledDFA.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// binary DFA file, version 1. native byte order, every section 8-byte aligned:
+//
+//   DFAFileHeader
+//   byte class map      uint8_t[256]
+//   prefilter first set 32-byte bitmap, then literalLength literal bytes
+//   transition table    uint32_t[numStates * width], DEAD = 0xFFFFFFFF
+//   accepting states    uint64_t[(numStates + 63) / 64], bit s = state s
+//   accept tags         int32_t[numStates], -1 if not accepting
+//
+// the arrays are laid out exactly as CompiledDFA uses them, so loading maps
+// the file and points at it without parsing
+//---------------------------------------------------------------------------------
+struct DFAFileHeader
+{
+    char magic[8];          // "SMVDFA" padded with zeros
+    uint32_t version;
+    uint32_t byteOrder;     // 0x01020304 as written
+    uint32_t numStates;
+    uint32_t width;         // byte classes
+    uint32_t startState;
+    uint32_t flags;         // DFA_FILE_PREFILTER
+    uint32_t literalLength;
+    uint32_t reserved;
+    uint64_t prefilterOffset;
+    uint64_t tableOffset;
+    uint64_t acceptOffset;
+    uint64_t tagsOffset;
+    uint64_t fileSize;
+};
+
+static constexpr uint32_t DFA_FILE_VERSION = 1;
+static constexpr uint32_t DFA_FILE_PREFILTER = 1; // the prefilter section is in use
+
+// write dfa to path, throws runtime_error if the file can't be written
+void SaveDFA(const CompiledDFA &dfa, const string &path);
+
+// map a file written by SaveDFA. the header and section bounds are checked;
+// the transition table itself is trusted unless verify is set, which scans
+// it once. throws runtime_error on a missing, foreign or corrupt file
+shared_ptr<const CompiledDFA> LoadDFA(const string &path, bool verify = false);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef GLUSHKOVNFA_H
+#define GLUSHKOVNFA_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include "MatchLoops.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class GlushkovNFA
+// the position automaton of a regex simulated as a 64-bit mask. bit 0 is the
+// start state and bit i the i-th symbol of the regex, so there are no epsilon
+// edges and one step is: active = follow(active) & mask[byte]. follow() is
+// looked up 8 positions at a time, so a step costs at most 8 table reads no
+// matter which positions are active. compiling takes time and memory linear
+// in the pattern and never builds a DFA state. immutable once built, so
+// matching is safe from many threads at once
+//---------------------------------------------------------------------------------
+class GlushkovNFA
+{
+public:
+    static constexpr size_t MAX_POSITIONS = 63;
+
+    // number of symbols in a postfix regex, the positions it needs
+    static size_t CountPositions(const string &postfix);
+
+    // throws invalid_argument on a malformed postfix or more than MAX_POSITIONS symbols
+    explicit GlushkovNFA(const string &postfix);
+
+    size_t NumPositions() const { return numPositions; }
+
+    size_t LongestMatch(string_view text, size_t pos) const;
+    bool matches(string_view text) const;
+    bool search(string_view text, MatchSpan &match) const;
+    size_t find_all(string_view text, const function<void(size_t, size_t)> &callback) const;
+
+    void setPrefilter(const Prefilter &newPrefilter) { prefilter = newPrefilter; }
+    const Prefilter &getPrefilter() const { return prefilter; }
+    size_t MemoryBytes() const;
+
+private:
+    // positions reachable in one step from any active position
+    uint64_t Follow(uint64_t active) const
+    {
+        uint64_t next = 0;
+        for (size_t chunk = 0; active; chunk++, active >>= 8)
+            next |= follow_tables[chunk][active & 0xFF];
+        return next;
+    }
+
+    size_t numPositions;
+    array<uint64_t, 256> byte_mask;          // positions labelled with each byte
+    vector<array<uint64_t, 256>> follow_tables; // [chunk][8 bits of the active mask]
+    uint64_t finals;                         // accepting positions, bit 0 if the regex is nullable
+    Prefilter prefilter;
+};
+
+#endif
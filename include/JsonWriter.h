@@ -0,0 +1,73 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class JsonWriter
+// writes JSON token by token into a fixed buffer that is handed to the
+// stream whenever it fills, so nothing the size of the document is ever in
+// memory. layout follows nlohmann::json::dump(indent): indent < 0 puts
+// everything on one line without spaces. the caller keeps the nesting
+// valid. strings are escaped, bytes that are not UTF-8 as \u00XX
+//---------------------------------------------------------------------------------
+class JsonWriter
+{
+public:
+    static constexpr size_t BUFFER_BYTES = 1 << 16;
+
+    explicit JsonWriter(ostream &out, int indent = -1);
+    ~JsonWriter(); // flushes
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter &operator=(const JsonWriter &) = delete;
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    void Key(string_view key);
+    void String(string_view value);
+    void Int(long long value);
+    // a serialized value, its line breaks indented to the current depth
+    void Raw(string_view json);
+
+    void Flush();
+
+private:
+    void BeforeValue();
+    void Quote(string_view value);
+    void Close(char bracket);
+    void Newline();
+    void Append(string_view text)
+    {
+        if (buffer.size() + text.size() > BUFFER_BYTES)
+        {
+            Flush();
+            if (text.size() > BUFFER_BYTES)
+            {
+                out.write(text.data(), text.size());
+                return;
+            }
+        }
+        buffer.append(text);
+    }
+    void Append(char c)
+    {
+        if (buffer.size() >= BUFFER_BYTES)
+            Flush();
+        buffer.push_back(c);
+    }
+
+    ostream &out;
+    string buffer;
+    int indent;
+    vector<bool> empty; // per open container: nothing written into it yet
+    bool afterKey;      // the next value belongs to the key just written
+};
+
+#endif
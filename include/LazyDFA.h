@@ -0,0 +1,77 @@
+#ifndef LAZYDFA_H
+#define LAZYDFA_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include "NFA.h"
+#include "StateSet.h"
+#include "MatchLoops.h"
+
+using namespace std;
+
+struct LazyDFAOptions
+{
+    size_t max_states = 4096;     // capacity of the DFA state cache
+    bool fallback_to_nfa = false; // when full: flush the cache (false) or simulate the NFA for uncached steps (true)
+};
+
+//---------------------------------------------------------------------------------
+// class LazyDFA
+// builds DFA states from NFA state sets only when the input reaches them.
+// computed states live in a bounded cache and epsilon closures are walked
+// on demand, so memory is the NFA's edges plus max_states cached states, no
+// matter how large the full subset construction would be
+//---------------------------------------------------------------------------------
+class LazyDFA
+{
+public:
+    explicit LazyDFA(const NFA &nfa, const LazyDFAOptions &options = LazyDFAOptions());
+
+    size_t LongestMatch(string_view text, size_t pos);
+    bool matches(string_view text);
+    bool search(string_view text, MatchSpan &match);
+    size_t find_all(string_view text, const function<void(size_t, size_t)> &callback);
+
+    void setPrefilter(const Prefilter &newPrefilter) { prefilter = newPrefilter; }
+    const Prefilter &getPrefilter() const { return prefilter; }
+
+    size_t CachedStates() const { return sets.size(); }
+    size_t Flushes() const { return flushes; }
+    size_t MemoryBytes() const; // upper bound, with the cache full
+
+private:
+    static constexpr uint32_t DEAD = 0xFFFFFFFFu;
+    static constexpr uint32_t UNKNOWN = 0xFFFFFFFEu;   // transition not computed yet
+    static constexpr uint32_t OFF_CACHE = 0xFFFFFFFDu; // successor did not fit in the cache
+
+    uint32_t AddState(const StateSet &set);
+    void Flush();
+    void AddClosure(int state, StateSet &out);
+    void Successor(const StateSet &from, int cls, StateSet &out);
+    uint32_t Compute(uint32_t state, int cls, StateSet &offCache);
+
+    LazyDFAOptions options;
+    int numNFAStates;
+    vector<vector<int>> epsilons;          // per NFA state: epsilon destinations
+    vector<vector<pair<int, int>>> edges;  // per NFA state: (byte class, destination)
+    StateSet finals;
+    StateSet startSet;
+    vector<int> pending;                   // AddClosure's stack, kept between calls
+    StateSet scratch;                      // Compute's successor, kept between calls
+
+    array<uint8_t, 256> byte_class;        // 0 for bytes outside the alphabet
+    uint32_t width;
+
+    unordered_map<StateSet, uint32_t, StateSetHash> ids;
+    vector<const StateSet *> sets;         // cached DFA states by id
+    vector<uint32_t> trans;                // sets.size() * width
+    vector<bool> accepting;
+    size_t flushes;
+    Prefilter prefilter;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class MappedFile
+// read-only memory map of a whole file, falls back to reading it into
+// memory where mmap is not available
+//---------------------------------------------------------------------------------
+class MappedFile
+{
+public:
+    // sequential: hint the kernel to read ahead, for streaming scans
+    explicit MappedFile(const string &path, bool sequential = true);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool IsOpen() const { return open; }
+    string_view Data() const { return string_view(data, size); }
+
+private:
+    bool open;
+    bool mapped;
+    const char *data;
+    size_t size;
+    string buffer; // used when the file could not be mapped
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef MATCHLOOPS_H
+#define MATCHLOOPS_H
+
+#include <cstddef>
+#include <string_view>
+#include <functional>
+#include "Prefilter.h"
+
+using namespace std;
+
+// half-open byte range [begin, end) of a match
+struct MatchSpan
+{
+    size_t begin;
+    size_t end;
+};
+
+static constexpr size_t NO_MATCH = string_view::npos;
+
+//---------------------------------------------------------------------------------
+// search and find-all on top of any engine's anchored longest match.
+// longest(text, pos) returns the end of the longest match starting at pos,
+// or NO_MATCH. positions the prefilter rules out are skipped without
+// running the engine
+//---------------------------------------------------------------------------------
+
+// leftmost-longest match anywhere in text
+template <typename Longest>
+bool SearchLoop(Longest &&longest, const Prefilter &prefilter, string_view text, MatchSpan &match)
+{
+    for (size_t pos = 0; pos <= text.size(); pos++)
+    {
+        pos = prefilter.NextCandidate(text, pos);
+        if (pos == NO_MATCH)
+            return false;
+        size_t end = longest(text, pos);
+        if (end != NO_MATCH)
+        {
+            match = {pos, end};
+            return true;
+        }
+    }
+    return false;
+}
+
+// every non-overlapping leftmost-longest match as (begin, end). after an
+// empty match the scan moves on by one byte. returns the number of matches
+template <typename Longest>
+size_t FindAllLoop(Longest &&longest, const Prefilter &prefilter, string_view text,
+                   const function<void(size_t, size_t)> &callback)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos <= text.size())
+    {
+        pos = prefilter.NextCandidate(text, pos);
+        if (pos == NO_MATCH)
+            break;
+        size_t end = longest(text, pos);
+        if (end == NO_MATCH)
+        {
+            pos++;
+            continue;
+        }
+        callback(pos, end);
+        count++;
+        pos = (end > pos) ? end : pos + 1;
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MULTIPATTERN_H
+#define MULTIPATTERN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <memory>
+#include "CompiledDFA.h"
+#include "CompileLimits.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class MultiPattern
+// many regexes unioned at the NFA level and compiled by one subset
+// construction. each accepting DFA state is tagged with the highest priority
+// (lowest index) pattern it accepts, so one pass over the input tells which
+// pattern matched
+//---------------------------------------------------------------------------------
+class MultiPattern
+{
+public:
+    // throws DFALimitExceeded when the combined DFA trips limits
+    explicit MultiPattern(const vector<string> &patterns, const CompileLimits &limits = CompileLimits());
+
+    size_t NumPatterns() const { return sources.size(); }
+    const string &Source(int pattern) const { return sources[pattern]; }
+    const CompiledDFA &getCompiled() const { return *table; }
+    shared_ptr<const CompiledDFA> Share() const { return table; }
+
+    // longest match anchored at pos, NO_MATCH if none. pattern is set to the
+    // highest priority pattern that matches that longest span
+    size_t LongestMatch(string_view text, size_t pos, int &pattern) const;
+
+    // lexer-style scan: reports non-empty tokens as (pattern, begin, end) and
+    // skips bytes where no pattern matches. returns the number of tokens
+    size_t Scan(string_view text, const function<void(int, size_t, size_t)> &callback) const;
+
+private:
+    vector<string> sources;
+    shared_ptr<const CompiledDFA> table;
+};
+
+#endif
@@ -7,34 +7,66 @@
 #include <queue>
 #include <stack>
 #include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "StateSet.h"
 using namespace std;
 
+struct NFAEdge
+{
+    int dst;
+    char sym; // '_' is epsilon
+};
+
+//---------------------------------------------------------------------------------
+// struct NFAArena
+// every edge of an NFA in one contiguous array, grouped by source state:
+// the edges of s are edges[offsets[s] .. offsets[s + 1]), sorted by (sym, dst)
+//---------------------------------------------------------------------------------
+struct NFAArena
+{
+    vector<uint32_t> offsets;
+    vector<NFAEdge> edges;
+
+    int NumStates() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    const NFAEdge *EdgesBegin(int s) const { return edges.data() + offsets[s]; }
+    const NFAEdge *EdgesEnd(int s) const { return edges.data() + offsets[s + 1]; }
+};
+
 //---------------------------------------------------------------------------------
 // class NFA
 // (S, Σ, δ, s0, F)
+// a view over an immutable arena, copies share the arena
 //---------------------------------------------------------------------------------
 class NFA
 {
 public:
-    NFA(set<char> A, int I, set<int> F) : alphabet(A), init_state(I), fin_states(F) {}
-    void AddTransition(int src, set<int> dst, char sym) { Ntran[src][sym] = dst; }
+    NFA(set<char> A, int I, set<int> F);
+    NFA(shared_ptr<const NFAArena> arena, set<char> A, int I, set<int> F)
+        : Narena(arena), alphabet(A), init_state(I), fin_states(F) {}
+    void AddTransition(int src, set<int> dst, char sym);
     set<char> getAlpha() const { return alphabet; }
     int getInitState() const { return init_state; }
-    set<int> getFinalStates() const { return fin_states; }
+    const set<int> &getFinalStates() const { return fin_states; }
     void setFinalStates(const set<int> &newFinalStates) { fin_states = newFinalStates; }
-    map<int, map<char, set<int>>> getNFATransitions() const { return Ntran; }
+    const NFAArena &getArena() const { return *Narena; }
+    map<int, map<char, set<int>>> getNFATransitions() const;
     void Print();
-    set<int> EpsilonClosureState(int state) const;  
-    set<int> EpsilonClosure(const set<int>& states) const;  
+    set<int> EpsilonClosureState(int state) const;
+    set<int> EpsilonClosure(const set<int>& states) const;
     set<int> move(const set<int>& T, char symbol) const;
+    int NumStates() const;
+    vector<StateSet> EpsilonClosures() const;
+    bool HasEpsilons() const;
     void ShiftStates(int offset);
     void Merge(const NFA &other);
 
 private:
-    map<int, map<char, set<int>>> Ntran; // NFA transitions
+    shared_ptr<const NFAArena> Narena; // NFA transitions
     set<char> alphabet;  // set of input symbols for a NFA
-    int init_state;      
-    set<int> fin_states; 
+    int init_state;
+    set<int> fin_states;
 };
 
-#endif
\ No newline at end of file
+#endif
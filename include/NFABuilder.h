@@ -0,0 +1,78 @@
+#ifndef NFABUILDER_H
+#define NFABUILDER_H
+
+#include <vector>
+#include <memory>
+#include "NFA.h"
+
+using namespace std;
+
+// a Thompson fragment: one start state and one final state in the arena.
+// move-only, so every fragment is consumed by exactly one operator
+struct NFAFragment
+{
+    int start;
+    int end;
+
+    NFAFragment(int s, int e) : start(s), end(e) {}
+    NFAFragment(NFAFragment &&) = default;
+    NFAFragment &operator=(NFAFragment &&) = default;
+    NFAFragment(const NFAFragment &) = delete;
+    NFAFragment &operator=(const NFAFragment &) = delete;
+};
+
+struct NFABuilderEdge
+{
+    int src;
+    int dst;
+    char sym;
+};
+
+// the states and edges one fragment added to the builder, for cloning.
+// a Thompson fragment never has edges leaving its own state range
+struct NFATemplate
+{
+    int firstState;
+    int numStates;
+    size_t firstEdge;
+    size_t numEdges;
+    int start;
+    int end;
+};
+
+//---------------------------------------------------------------------------------
+// class NFABuilder
+// appends states and edges to a single arena. fragments are index pairs,
+// so concatenation, star and alternation only add states and edges and
+// never shift or copy what is already there
+//---------------------------------------------------------------------------------
+class NFABuilder
+{
+public:
+    NFABuilder() : numStates(0), alphabet{} {}
+    void Reserve(size_t edges) { pending.reserve(edges); }
+    int AddState() { return numStates++; }
+    void AddEdge(int src, int dst, char sym);
+    int NumStates() const { return numStates; }
+    size_t NumEdges() const { return pending.size(); }
+
+    NFAFragment Symbol(char c);
+    NFAFragment Concat(NFAFragment first, NFAFragment second);
+    NFAFragment Star(NFAFragment inner);
+    NFAFragment Union(NFAFragment left, NFAFragment right);
+
+    // a copy of an earlier fragment, numbered exactly as building it again would
+    NFAFragment Clone(const NFATemplate &source);
+
+    NFA Finish(NFAFragment whole);
+
+    // sort edges into the contiguous per-state layout of NFAArena
+    static shared_ptr<const NFAArena> BuildArena(int numStates, vector<NFABuilderEdge> &edges);
+
+private:
+    int numStates;
+    vector<NFABuilderEdge> pending;
+    bool alphabet[256]; // symbols seen so far
+};
+
+#endif
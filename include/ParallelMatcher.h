@@ -0,0 +1,69 @@
+#ifndef PARALLELMATCHER_H
+#define PARALLELMATCHER_H
+
+#include <cstdint>
+#include <vector>
+#include <string_view>
+#include <functional>
+#include "CompiledDFA.h"
+#include "StreamMatcher.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class ParallelMatcher
+// data-parallel DFA simulation. the input is cut into chunks that run on a
+// thread pool; every chunk but the first is simulated speculatively from
+// each state the DFA could be in at its start, then a sequential prefix
+// pass stitches the per-chunk state maps together.
+//
+// find_all speculates on where the scan resumes instead: each chunk runs a
+// StreamMatcher as if a scan began at its first byte, and the stitch pass
+// keeps those matches from the first offset the real scan also tries
+//---------------------------------------------------------------------------------
+class ParallelMatcher
+{
+public:
+    ParallelMatcher(const CompiledDFA &dfa, ThreadPool &pool, size_t minChunk = 1 << 16);
+
+    // state after running the whole of text from the start state (DEAD if it died)
+    uint32_t FinalState(string_view text) const;
+    bool matches(string_view text) const;
+
+    // StreamMatcher's matches over text, in order on the calling thread. chunks
+    // are minChunk bytes, a few per worker at a time, so memory stays bounded
+    size_t find_all(string_view text, const function<void(size_t, size_t)> &callback,
+                    size_t maxMatchBytes = StreamMatcher::DEFAULT_MAX_MATCH) const;
+
+private:
+    // end state of one chunk for each candidate start state
+    struct ChunkMap
+    {
+        vector<uint32_t> from; // sorted candidate start states
+        vector<uint32_t> to;   // end state for each candidate
+        uint32_t Lookup(uint32_t state) const;
+    };
+
+    // matches of a scan that begins at offset begin, up to the first attempt at or past end
+    struct SpeculativeScan
+    {
+        size_t end;
+        vector<MatchSpan> matches;
+        size_t exit; // where the scan goes on after end
+    };
+
+    size_t ChunkSizeFor(size_t length) const;
+    vector<uint32_t> Candidates(unsigned char previous) const;
+    ChunkMap RunChunk(string_view chunk, const vector<uint32_t> &starts) const;
+    vector<ChunkMap> RunChunks(string_view text, size_t chunkSize) const;
+    SpeculativeScan ScanFrom(string_view text, size_t begin, size_t end, size_t maxMatch) const;
+    size_t Stitch(string_view text, const SpeculativeScan &scan, size_t &resume,
+                  const function<void(size_t, size_t)> &callback, size_t maxMatch) const;
+
+    const CompiledDFA &table;
+    ThreadPool &pool;
+    size_t minChunk;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "DFA.h"
+#include "LazyDFA.h"
+#include "GlushkovNFA.h"
+#include "MatchLoops.h"
+#include "CompileLimits.h"
+
+using namespace std;
+
+// AUTO picks one of the others per pattern, Pattern::Engine() tells which
+enum class MatchEngine {FULL_DFA, LAZY_DFA, BIT_PARALLEL, AUTO};
+
+struct PatternOptions
+{
+    MatchEngine engine = MatchEngine::AUTO;
+    size_t autoMaxStates = 1024; // AUTO: largest DFA worth building before simulating instead
+    bool minimize = true;    // FULL_DFA only
+    CompileLimits limits;    // FULL_DFA only, bounds the subset construction
+    bool lazyFallback = true; // FULL_DFA: switch to LAZY_DFA when a limit trips instead of throwing
+    LazyDFAOptions lazy;     // LAZY_DFA and the fallback
+};
+
+//---------------------------------------------------------------------------------
+// class Pattern
+// a regex compiled for matching with the engine chosen in its options.
+// matching is safe from many threads at once: the full DFA and the
+// bit-parallel NFA are immutable, the lazy engine's cache is guarded by a mutex
+//---------------------------------------------------------------------------------
+class Pattern
+{
+public:
+    explicit Pattern(const string &infix, const PatternOptions &options = PatternOptions());
+
+    const string &Source() const { return source; }
+    MatchEngine Engine() const { return engine; } // LAZY_DFA after a fallback
+    const DFA &getDFA() const { return dfa; }     // FULL_DFA only
+    const LazyDFA *getLazyDFA() const { return lazy.get(); }
+    const GlushkovNFA *getGlushkovNFA() const { return glushkov.get(); }
+    shared_ptr<const CompiledDFA> getCompiled() const { return table; } // FULL_DFA only, null otherwise
+    size_t MemoryBytes() const; // approximate
+
+    bool matches(string_view text) const;
+    bool search(string_view text, MatchSpan &match) const;
+    size_t find_all(string_view text, const function<void(size_t, size_t)> &callback) const;
+
+private:
+    string source;
+    MatchEngine engine;
+    DFA dfa;
+    shared_ptr<const CompiledDFA> table;
+    unique_ptr<LazyDFA> lazy; // its cache changes while matching
+    unique_ptr<GlushkovNFA> glushkov;
+    mutable mutex lazyLock;
+};
+
+#endif
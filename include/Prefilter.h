@@ -0,0 +1,57 @@
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include <cstdint>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+class RegexDAG;
+
+//---------------------------------------------------------------------------------
+// class Prefilter
+// what every match of a pattern must start with: a required leading literal
+// and/or the set of possible first bytes. search uses it to skip straight to
+// candidate positions with a SIMD scan before running the automaton.
+// a disabled prefilter (nullable patterns) accepts every position
+//---------------------------------------------------------------------------------
+class Prefilter
+{
+public:
+    Prefilter() : enabled(false), numFirstBytes(0), bytes{} { first.fill(false); }
+    // enabled prefilter from its parts, literal may be empty
+    Prefilter(const array<bool, 256> &firstBytes, const string &requiredLiteral);
+
+    // analysis over the postfix produced by InfixToPostfix
+    static Prefilter FromPostfix(const string &postfix);
+    // same analysis, done once per distinct subexpression
+    static Prefilter FromDAG(const RegexDAG &dag);
+
+    bool Enabled() const { return enabled; }
+    const string &Literal() const { return literal; }
+    bool IsFirstByte(unsigned char c) const { return first[c]; }
+    size_t NumFirstBytes() const { return numFirstBytes; }
+
+    // first position >= pos where a match could start, npos if there is none
+    size_t NextCandidate(string_view text, size_t pos) const;
+
+    // name of the scan kernel picked for this CPU ("avx2", "sse2" or "scalar")
+    static const char *Kernel();
+    // the kernels this CPU runs, best first
+    static vector<string> Kernels();
+    // scan with the named kernel from now on, false if this CPU cannot run it.
+    // for tests and benchmarks: no scan may be running meanwhile
+    static bool UseKernel(const string &name);
+
+private:
+    bool enabled;
+    string literal;           // required prefix, used when it has 2+ bytes
+    array<bool, 256> first;   // possible first bytes
+    size_t numFirstBytes;
+    array<uint8_t, 3> bytes;  // the first bytes when there are at most 3
+};
+
+#endif
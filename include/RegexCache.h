@@ -0,0 +1,71 @@
+#ifndef REGEXCACHE_H
+#define REGEXCACHE_H
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include "Pattern.h"
+
+using namespace std;
+
+struct RegexCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;    // compilations started
+    size_t coalesced = 0; // lookups that waited for another thread's compilation
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;     // approximate, see Pattern::MemoryBytes
+};
+
+//---------------------------------------------------------------------------------
+// class RegexCache
+// thread-safe LRU cache from normalized pattern text to compiled Patterns.
+// least recently used entries are evicted to stay within a memory budget.
+// concurrent lookups of a pattern that is still compiling wait for that one
+// compilation instead of starting their own. failed compilations are not
+// cached, every lookup rethrows its own error
+//---------------------------------------------------------------------------------
+class RegexCache
+{
+public:
+    static constexpr size_t DEFAULT_BUDGET = 64 << 20;
+
+    explicit RegexCache(size_t budgetBytes = DEFAULT_BUDGET, const PatternOptions &options = PatternOptions());
+
+    // process-wide cache with the default budget and options
+    static RegexCache &Global();
+
+    // whitespace is not part of the regex syntax
+    static string Normalize(const string &infix);
+
+    shared_ptr<const Pattern> Get(const string &infix);
+
+    void SetBudget(size_t budgetBytes);
+    size_t Budget() const;
+    RegexCacheStats Stats() const;
+    void Clear(); // drops every entry; hits, misses, coalesced and evictions keep counting
+
+private:
+    struct Entry
+    {
+        shared_ptr<const Pattern> pattern;
+        size_t bytes;
+        list<string>::iterator recent; // position in lru
+    };
+
+    void EvictOverBudget();
+
+    PatternOptions options;
+    mutable mutex lock;
+    size_t budget;
+    list<string> lru;                     // most recently used first
+    unordered_map<string, Entry> entries;
+    unordered_map<string, shared_future<shared_ptr<const Pattern>>> compiling;
+    RegexCacheStats stats;
+};
+
+#endif
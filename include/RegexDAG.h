@@ -0,0 +1,55 @@
+#ifndef REGEXDAG_H
+#define REGEXDAG_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// one operator or symbol. children are node ids, -1 where there is none
+struct RegexDAGNode
+{
+    char op; // a symbol, '*', '.' or '|'
+    int left;
+    int right;
+};
+
+struct RegexDAGStats
+{
+    size_t treeNodes = 0;    // nodes of the regex written out as a tree
+    size_t dagNodes = 0;     // distinct subexpressions
+    size_t sharedNodes = 0;  // operators that occur more than once
+    size_t largestShared = 0; // tree size of the largest repeated operator
+};
+
+//---------------------------------------------------------------------------------
+// class RegexDAG
+// a postfix regex parsed into a hash-consed expression DAG: structurally
+// equal subexpressions become one node, however often they are repeated.
+// children always have smaller ids than their parents, so ascending id order
+// is a bottom-up order
+//---------------------------------------------------------------------------------
+class RegexDAG
+{
+public:
+    // throws invalid_argument on a malformed postfix
+    static RegexDAG FromPostfix(const string &postfix);
+
+    size_t NumNodes() const { return nodes.size(); }
+    int Root() const { return root; }
+    const RegexDAGNode &Node(int id) const { return nodes[id]; }
+    size_t TreeSize(int id) const { return treeSize[id]; }       // saturates at SIZE_MAX
+    size_t Occurrences(int id) const { return occurrences[id]; } // times the tree contains it
+    RegexDAGStats Stats() const;
+
+private:
+    RegexDAG() : root(-1) {}
+
+    vector<RegexDAGNode> nodes;
+    vector<size_t> treeSize;
+    vector<size_t> occurrences;
+    int root;
+};
+
+#endif
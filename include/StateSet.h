@@ -0,0 +1,86 @@
+#ifndef STATESET_H
+#define STATESET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class StateSet
+// dense dynamic bitset over NFA states 0..n-1, used as the key of DFA states
+// during subset construction
+//---------------------------------------------------------------------------------
+class StateSet
+{
+public:
+    StateSet() {}
+    explicit StateSet(size_t n) : words((n + 63) / 64, 0) {}
+
+    void Insert(int s) { words[s >> 6] |= uint64_t(1) << (s & 63); }
+    bool Contains(int s) const { return (words[s >> 6] >> (s & 63)) & 1; }
+    void Clear() { for (uint64_t &w : words) w = 0; }
+
+    void UnionWith(const StateSet &other)
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            words[i] |= other.words[i];
+    }
+
+    bool Intersects(const StateSet &other) const
+    {
+        for (size_t i = 0; i < words.size(); i++)
+            if (words[i] & other.words[i])
+                return true;
+        return false;
+    }
+
+    bool Empty() const
+    {
+        for (uint64_t w : words)
+            if (w)
+                return false;
+        return true;
+    }
+
+    // call f(state) for every member in ascending order
+    template <typename F>
+    void ForEach(F f) const
+    {
+        for (size_t i = 0; i < words.size(); i++)
+        {
+            uint64_t w = words[i];
+            while (w)
+            {
+                f(int(i * 64 + __builtin_ctzll(w)));
+                w &= w - 1;
+            }
+        }
+    }
+
+    size_t Hash() const
+    {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (uint64_t w : words)
+        {
+            h ^= w;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 32;
+        }
+        return h;
+    }
+
+    bool operator==(const StateSet &other) const { return words == other.words; }
+    const vector<uint64_t> &Words() const { return words; }
+
+private:
+    vector<uint64_t> words;
+};
+
+struct StateSetHash
+{
+    size_t operator()(const StateSet &s) const { return s.Hash(); }
+};
+
+#endif
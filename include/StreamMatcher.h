@@ -0,0 +1,81 @@
+#ifndef STREAMMATCHER_H
+#define STREAMMATCHER_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include "CompiledDFA.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class StreamMatcher
+// find_all over a stream fed in chunks. the DFA state survives chunk
+// boundaries and matches are reported as offsets into the whole stream.
+// chunks are read in place; only the bytes a pending match may still need
+// to rescan are copied into a carry buffer.
+//
+// an attempt that runs for maxMatchBytes without dying is cut off there: it
+// reports its longest match so far, if any, and counts in Truncated(). so the
+// carry holds at most maxMatchBytes bytes and the restart memo at most
+// 2 * maxMatchBytes four-byte states: under 9 * maxMatchBytes bytes (9 MiB by
+// default) besides the caller's chunk, whatever the stream length. with no attempt cut off the matches are exactly
+// those of find_all over the whole stream.
+//
+// a restarted attempt that reaches the DFA state the previous attempt had at
+// the same offset stops there and takes over that attempt's outcome, so the
+// bytes after a restart are not scanned again and a scan stays linear
+//---------------------------------------------------------------------------------
+class StreamMatcher
+{
+public:
+    static constexpr size_t DEFAULT_MAX_MATCH = 1 << 20;
+
+    StreamMatcher(const CompiledDFA &dfa, const function<void(size_t, size_t)> &callback,
+                  size_t maxMatchBytes = DEFAULT_MAX_MATCH);
+
+    void Feed(string_view chunk);
+    void Finish();   // end of stream, reports the matches still pending
+    void Reset();
+
+    size_t BytesFed() const { return streamPos; }
+    size_t Matches() const { return matches; }
+    size_t Truncated() const { return truncated; } // attempts cut off at maxMatchBytes
+    size_t PendingStart() const { return attemptStart; } // no match reported later begins before this
+
+private:
+    bool Step(const char *data, size_t base, size_t end);
+    void GrowMemo();
+    void Resolve();
+    void StartAttempt(size_t pos);
+    void SkipToCandidate(string_view chunk, size_t chunkBase);
+
+    const CompiledDFA &table;
+    function<void(size_t, size_t)> onMatch;
+    size_t maxMatch;
+
+    size_t streamPos;    // bytes fed so far
+    size_t attemptStart; // where the current match attempt began
+    size_t scanned;      // next byte the attempt will consume
+    size_t lastAccept;   // end of the longest match of this attempt so far
+    bool cut;            // the attempt hit maxMatch
+    uint32_t state;
+    string carry;        // stream bytes [carryStart, start of current chunk)
+    size_t carryStart;
+    size_t matches;
+    size_t truncated;
+
+    // the DFA state after each byte of the current attempt, or of the last
+    // finished one past where the current attempt has got to. a ring indexed
+    // by stream offset, holding offsets [memoBase, memoTop)
+    vector<uint32_t> memo;
+    size_t memoBase;
+    size_t memoTop;
+    size_t memoEnd;       // where the last finished attempt ended, later states are stale
+    size_t memoAccept;    // its longest match end
+    bool memoCut;         // and whether it was cut off
+};
+
+#endif
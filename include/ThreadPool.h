@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class ThreadPool
+// fixed set of worker threads pulling tasks from one shared queue
+//---------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads = 0); // 0 means one per hardware thread
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t Size() const { return workers.size(); }
+
+    // queue a task, the future carries its result or exception
+    template <typename F>
+    auto Submit(F task) -> future<decltype(task())>
+    {
+        using R = decltype(task());
+        auto packaged = make_shared<packaged_task<R()>>(move(task));
+        future<R> result = packaged->get_future();
+        {
+            lock_guard<mutex> lock(queueMutex);
+            tasks.push([packaged]() { (*packaged)(); });
+        }
+        wakeup.notify_one();
+        return result;
+    }
+
+    // run body(0) .. body(n - 1) on the pool and wait for all of them
+    void ParallelFor(size_t n, const function<void(size_t)> &body);
+
+private:
+    void WorkerLoop();
+
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable wakeup;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "../include/AllocTracker.h"
+
+#ifdef TRACK_ALLOCATIONS
+
+static atomic<size_t> currentBytes{0};
+static atomic<size_t> peakBytes{0};
+static atomic<size_t> allocations{0};
+
+// every block carries its size in a header that keeps the default alignment
+static constexpr size_t HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+static void *TrackedAlloc(size_t size) noexcept
+{
+    void *block = malloc(size + HEADER);
+    if (!block)
+        return nullptr;
+    *static_cast<size_t *>(block) = size;
+    allocations.fetch_add(1, memory_order_relaxed);
+    size_t now = currentBytes.fetch_add(size, memory_order_relaxed) + size;
+    size_t peak = peakBytes.load(memory_order_relaxed);
+    while (now > peak && !peakBytes.compare_exchange_weak(peak, now, memory_order_relaxed))
+    {
+    }
+    return static_cast<char *>(block) + HEADER;
+}
+
+static void TrackedFree(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    void *block = static_cast<char *>(ptr) - HEADER;
+    currentBytes.fetch_sub(*static_cast<size_t *>(block), memory_order_relaxed);
+    free(block);
+}
+
+static void *TrackedNew(size_t size)
+{
+    for (;;)
+    {
+        if (void *ptr = TrackedAlloc(size))
+            return ptr;
+        new_handler handler = get_new_handler();
+        if (!handler)
+            throw bad_alloc();
+        handler();
+    }
+}
+
+void *operator new(size_t size) { return TrackedNew(size); }
+void *operator new[](size_t size) { return TrackedNew(size); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return TrackedAlloc(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return TrackedAlloc(size); }
+void operator delete(void *ptr) noexcept { TrackedFree(ptr); }
+void operator delete[](void *ptr) noexcept { TrackedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { TrackedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { TrackedFree(ptr); }
+void operator delete(void *ptr, const nothrow_t &) noexcept { TrackedFree(ptr); }
+void operator delete[](void *ptr, const nothrow_t &) noexcept { TrackedFree(ptr); }
+
+bool AllocTracker::Enabled() { return true; }
+size_t AllocTracker::CurrentBytes() { return currentBytes.load(memory_order_relaxed); }
+size_t AllocTracker::PeakBytes() { return peakBytes.load(memory_order_relaxed); }
+size_t AllocTracker::Allocations() { return allocations.load(memory_order_relaxed); }
+void AllocTracker::ResetPeak() { peakBytes.store(currentBytes.load(memory_order_relaxed), memory_order_relaxed); }
+
+#else
+
+bool AllocTracker::Enabled() { return false; }
+size_t AllocTracker::CurrentBytes() { return 0; }
+size_t AllocTracker::PeakBytes() { return 0; }
+size_t AllocTracker::Allocations() { return 0; }
+void AllocTracker::ResetPeak() {}
+
+#endif
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include "../include/CompiledDFA.h"
+
+//---------------------------------------------------------------------------------
+// empty automaton: a single non-accepting state with no transitions
+//---------------------------------------------------------------------------------
+CompiledDFA::CompiledDFA()
+{
+    Build({}, {}, vector<int>(1, -1));
+    start_state = 0;
+    original_ids = {0};
+}
+
+//---------------------------------------------------------------------------------
+// compile the map form. states are renumbered densely in ascending id order
+//---------------------------------------------------------------------------------
+CompiledDFA::CompiledDFA(const map<int, map<char, int>> &Dtran, int start, const set<int> &finals)
+{
+    // Collect every state mentioned anywhere
+    set<int> allStates = finals;
+    set<char> alphabet;
+    allStates.insert(start);
+    for (const auto &row : Dtran)
+    {
+        allStates.insert(row.first);
+        for (const auto &trans : row.second)
+        {
+            allStates.insert(trans.second);
+            alphabet.insert(trans.first);
+        }
+    }
+    original_ids.assign(allStates.begin(), allStates.end());
+
+    vector<char> symbols(alphabet.begin(), alphabet.end());
+    vector<vector<uint32_t>> columns(symbols.size(), vector<uint32_t>(original_ids.size(), DEAD));
+    for (const auto &row : Dtran)
+    {
+        uint32_t src = DenseId(row.first);
+        for (const auto &trans : row.second)
+        {
+            size_t col = lower_bound(symbols.begin(), symbols.end(), trans.first) - symbols.begin();
+            columns[col][src] = DenseId(trans.second);
+        }
+    }
+
+    vector<int> tags(original_ids.size(), -1);
+    for (int s : finals)
+        tags[DenseId(s)] = 0;
+
+    Build(symbols, columns, tags);
+    start_state = DenseId(start);
+}
+
+//---------------------------------------------------------------------------------
+// compile dense rows as produced by subset construction, ids are kept as is
+//---------------------------------------------------------------------------------
+CompiledDFA::CompiledDFA(const vector<char> &symbols, const vector<vector<int>> &rows,
+                         const vector<int> &tags, int start)
+{
+    vector<vector<uint32_t>> columns(symbols.size(), vector<uint32_t>(rows.size(), DEAD));
+    for (size_t s = 0; s < rows.size(); s++)
+        for (size_t i = 0; i < symbols.size(); i++)
+            if (rows[s][i] >= 0)
+                columns[i][s] = rows[s][i];
+
+    original_ids.resize(rows.size());
+    for (size_t s = 0; s < rows.size(); s++)
+        original_ids[s] = s;
+
+    Build(symbols, columns, tags);
+    start_state = start;
+}
+
+//---------------------------------------------------------------------------------
+// byte-class compression: bytes whose columns are identical share a class.
+// class 0 is the all-dead column used by every byte outside the alphabet
+//---------------------------------------------------------------------------------
+void CompiledDFA::Build(const vector<char> &symbols, const vector<vector<uint32_t>> &columns,
+                        const vector<int> &tags)
+{
+    num_states = tags.size();
+
+    vector<vector<uint32_t>> classColumns;
+    map<vector<uint32_t>, uint8_t> classOf;
+    classColumns.push_back(vector<uint32_t>(num_states, DEAD));
+    classOf[classColumns[0]] = 0;
+    byte_class.fill(0);
+
+    for (size_t i = 0; i < symbols.size(); i++)
+    {
+        auto found = classOf.find(columns[i]);
+        if (found == classOf.end())
+        {
+            found = classOf.emplace(columns[i], classColumns.size()).first;
+            classColumns.push_back(columns[i]);
+        }
+        byte_class[(unsigned char)symbols[i]] = found->second;
+    }
+    width = classColumns.size();
+
+    own_table.assign((size_t)num_states * width, DEAD);
+    for (uint32_t cls = 0; cls < width; cls++)
+        for (uint32_t s = 0; s < num_states; s++)
+            own_table[(size_t)s * width + cls] = classColumns[cls][s];
+
+    own_accept_tags = tags;
+    own_accept_bits.assign((num_states + 63) / 64, 0);
+    for (uint32_t s = 0; s < num_states; s++)
+        if (tags[s] >= 0)
+            own_accept_bits[s >> 6] |= uint64_t(1) << (s & 63);
+    Attach();
+}
+
+//---------------------------------------------------------------------------------
+// view over external arrays, nothing is copied but the 256 byte class map
+//---------------------------------------------------------------------------------
+CompiledDFA::CompiledDFA(uint32_t states, uint32_t classes, uint32_t start, const uint8_t *byteClasses,
+                         const uint32_t *transitions, const uint64_t *acceptBits, const int *acceptTags,
+                         shared_ptr<const void> keepAlive)
+    : num_states(states), width(classes), start_state(start), table(transitions), accept_bits(acceptBits),
+      accept_tags(acceptTags), backing(move(keepAlive))
+{
+    copy(byteClasses, byteClasses + 256, byte_class.begin());
+}
+
+//---------------------------------------------------------------------------------
+// copies share a backing object, owned arrays are copied and re-pointed
+//---------------------------------------------------------------------------------
+CompiledDFA::CompiledDFA(const CompiledDFA &other)
+{
+    *this = other;
+}
+
+CompiledDFA &CompiledDFA::operator=(const CompiledDFA &other)
+{
+    num_states = other.num_states;
+    width = other.width;
+    start_state = other.start_state;
+    byte_class = other.byte_class;
+    table = other.table;
+    accept_bits = other.accept_bits;
+    accept_tags = other.accept_tags;
+    own_table = other.own_table;
+    own_accept_bits = other.own_accept_bits;
+    own_accept_tags = other.own_accept_tags;
+    backing = other.backing;
+    original_ids = other.original_ids;
+    prefilter = other.prefilter;
+    if (!backing)
+        Attach();
+    return *this;
+}
+
+//---------------------------------------------------------------------------------
+// point the views at the owned arrays
+//---------------------------------------------------------------------------------
+void CompiledDFA::Attach()
+{
+    table = own_table.data();
+    accept_bits = own_accept_bits.data();
+    accept_tags = own_accept_tags.data();
+}
+
+//---------------------------------------------------------------------------------
+// end of the longest match anchored at pos, NO_MATCH if there is none.
+// stops as soon as the DFA reaches the dead state
+//---------------------------------------------------------------------------------
+size_t CompiledDFA::LongestMatch(string_view text, size_t pos) const
+{
+    const uint32_t *trans = table;
+    const uint8_t *classes = byte_class.data();
+    uint32_t state = start_state;
+    size_t last = IsAccepting(state) ? pos : NO_MATCH;
+
+    for (size_t i = pos; i < text.size(); i++)
+    {
+        state = trans[state * width + classes[(unsigned char)text[i]]];
+        if (state == DEAD)
+            break;
+        if (IsAccepting(state))
+            last = i + 1;
+    }
+    return last;
+}
+
+//---------------------------------------------------------------------------------
+// does the whole of text match
+//---------------------------------------------------------------------------------
+bool CompiledDFA::matches(string_view text) const
+{
+    const uint32_t *trans = table;
+    const uint8_t *classes = byte_class.data();
+    uint32_t state = start_state;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        state = trans[state * width + classes[(unsigned char)text[i]]];
+        if (state == DEAD)
+            return false;
+    }
+    return IsAccepting(state);
+}
+
+//---------------------------------------------------------------------------------
+// leftmost-longest match anywhere in text
+//---------------------------------------------------------------------------------
+bool CompiledDFA::search(string_view text, MatchSpan &match) const
+{
+    return SearchLoop([this](string_view t, size_t pos) { return LongestMatch(t, pos); }, prefilter, text, match);
+}
+
+//---------------------------------------------------------------------------------
+// every non-overlapping leftmost-longest match, returns the count
+//---------------------------------------------------------------------------------
+size_t CompiledDFA::find_all(string_view text, const function<void(size_t, size_t)> &callback) const
+{
+    return FindAllLoop([this](string_view t, size_t pos) { return LongestMatch(t, pos); }, prefilter, text, callback);
+}
+
+//---------------------------------------------------------------------------------
+// heap and object bytes held by the table
+//---------------------------------------------------------------------------------
+size_t CompiledDFA::MemoryBytes() const
+{
+    return sizeof(*this) + own_table.capacity() * sizeof(uint32_t) + own_accept_bits.capacity() * sizeof(uint64_t) +
+           own_accept_tags.capacity() * sizeof(int) + original_ids.capacity() * sizeof(int) +
+           prefilter.Literal().capacity();
+}
+
+//---------------------------------------------------------------------------------
+// dense id of a map-form state, DEAD if the state is unknown
+//---------------------------------------------------------------------------------
+uint32_t CompiledDFA::DenseId(int original) const
+{
+    if (original_ids.empty())
+        return (original >= 0 && (uint32_t)original < num_states) ? original : DEAD;
+    auto found = lower_bound(original_ids.begin(), original_ids.end(), original);
+    if (found == original_ids.end() || *found != original)
+        return DEAD;
+    return found - original_ids.begin();
+}
+
+//---------------------------------------------------------------------------------
+// expand back into the map form, used for JSON export
+//---------------------------------------------------------------------------------
+map<int, map<char, int>> CompiledDFA::ToMap() const
+{
+    map<int, map<char, int>> Dtran;
+    for (uint32_t s = 0; s < num_states; s++)
+    {
+        for (int c = 0; c < 256; c++)
+        {
+            uint32_t dst = Next(s, c);
+            if (dst != DEAD)
+                Dtran[OriginalId(s)][(char)c] = OriginalId(dst);
+        }
+    }
+    return Dtran;
+}
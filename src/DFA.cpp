@@ -9,18 +9,22 @@
 //---------------------------------------------------------------------------------
 // DFA ctor
 //---------------------------------------------------------------------------------
-DFA::DFA(set<char> A, set<int> I, set<int> F) : init_states(I), fin_states(F)
+DFA::DFA(set<char> A, set<int> I, set<int> F)
+    : table(make_shared<const CompiledDFA>()), current_state(0), init_states(I), fin_states(F), compiled(false)
 {
     Reset();
 }
 
 void DFA::Reset() 
 {
+    if (!compiled)
+        Compile();
+
     status = START; 
-    current_state = *init_states.begin(); 
+    current_state = table->Start(); 
     
     // Check if the initial state is a final state
-    if (fin_states.count(current_state) > 0) {
+    if (table->IsAccepting(current_state)) {
         status = ACCEPT;
         accepted = true;
         lexeme.clear();
@@ -32,19 +36,97 @@ void DFA::Reset()
     lexeme.clear();
 }
 
+//---------------------------------------------------------------------------------
+// rebuild the flat table from the map form
+//---------------------------------------------------------------------------------
+void DFA::Compile()
+{
+    int start = init_states.empty() ? 0 : *init_states.begin();
+    Install(make_shared<CompiledDFA>(Dtran, start, fin_states));
+}
+
+//---------------------------------------------------------------------------------
+// use a table built elsewhere (e.g. straight from subset construction)
+//---------------------------------------------------------------------------------
+void DFA::setCompiled(CompiledDFA newTable)
+{
+    Install(make_shared<CompiledDFA>(move(newTable)));
+}
+
+//---------------------------------------------------------------------------------
+// the table is shared, so a new prefilter means a new table
+//---------------------------------------------------------------------------------
+void DFA::setPrefilter(const Prefilter &newPrefilter)
+{
+    prefilter = newPrefilter;
+    if (compiled)
+        Install(make_shared<CompiledDFA>(*table));
+}
+
+//---------------------------------------------------------------------------------
+// swap in a new table, keeping the current state across the renumbering.
+// the table is frozen from here on
+//---------------------------------------------------------------------------------
+void DFA::Install(shared_ptr<CompiledDFA> newTable)
+{
+    newTable->setPrefilter(prefilter);
+    int original = table->OriginalId(current_state);
+    table = move(newTable);
+    compiled = true;
+
+    uint32_t dense = table->DenseId(original);
+    current_state = (dense != CompiledDFA::DEAD) ? dense : table->Start();
+}
+
+//---------------------------------------------------------------------------------
+// the current table, or a fresh one if transitions were added since the
+// last compile. never touches the match state
+//---------------------------------------------------------------------------------
+shared_ptr<const CompiledDFA> DFA::Snapshot() const
+{
+    if (compiled)
+        return table;
+    int start = init_states.empty() ? 0 : *init_states.begin();
+    auto snapshot = make_shared<CompiledDFA>(Dtran, start, fin_states);
+    snapshot->setPrefilter(prefilter);
+    return snapshot;
+}
+
+//---------------------------------------------------------------------------------
+// buffer-level matching, independent of Move/Reset state
+//---------------------------------------------------------------------------------
+bool DFA::matches(string_view text) const
+{
+    return compiled ? table->matches(text) : Snapshot()->matches(text);
+}
+
+bool DFA::search(string_view text, MatchSpan &match) const
+{
+    return compiled ? table->search(text, match) : Snapshot()->search(text, match);
+}
+
+size_t DFA::find_all(string_view text, const function<void(size_t, size_t)> &callback) const
+{
+    return compiled ? table->find_all(text, callback) : Snapshot()->find_all(text, callback);
+}
+
 //---------------------------------------------------------------------------------
 // Move from one state, s, to another based on input char,
 // possibly changing both the current state and the status of the DFS
 //---------------------------------------------------------------------------------
 void DFA::Move( char c) 
 { 
-    //---- check if c is in the map for transitions
-    if (Dtran[current_state].find(c) != Dtran[current_state].end()) 
+    if (!compiled)
+        Compile();
+
+    //---- one table lookup, DEAD if there is no transition on c
+    uint32_t next = table->Next(current_state, c);
+    if (next != CompiledDFA::DEAD) 
     {
-        current_state = Dtran[current_state][c];
+        current_state = next;
         lexeme += c;
 
-        if (fin_states.count(current_state) > 0)
+        if (table->IsAccepting(current_state))
         {
             status = ACCEPT;
             accepted = true;
@@ -57,6 +139,17 @@ void DFA::Move( char c)
         status = FAIL;
 }
 
+//---------------------------------------------------------------------------------
+// number of transitions in the map form
+//---------------------------------------------------------------------------------
+size_t DFA::NumTransitions() const
+{
+    size_t count = 0;
+    for (const auto& dfa_row : Dtran)
+        count += dfa_row.second.size();
+    return count;
+}
+
 //---------------------------------------------------------------------------------
 // print the DFA
 //---------------------------------------------------------------------------------
@@ -0,0 +1,121 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "../include/DFAFile.h"
+#include "../include/MappedFile.h"
+
+static_assert(sizeof(DFAFileHeader) == 80, "DFAFileHeader must have no padding");
+static_assert(sizeof(int) == sizeof(int32_t), "accept tags are stored as int32_t");
+
+static const char DFA_FILE_MAGIC[8] = {'S', 'M', 'V', 'D', 'F', 'A', 0, 0};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static uint64_t Align8(uint64_t offset)
+{
+    return (offset + 7) & ~uint64_t(7);
+}
+
+//---------------------------------------------------------------------------------
+// write the header and every section at the offsets it records
+//---------------------------------------------------------------------------------
+void SaveDFA(const CompiledDFA &dfa, const string &path)
+{
+    const Prefilter &prefilter = dfa.getPrefilter();
+    uint64_t n = dfa.NumStates();
+
+    DFAFileHeader header{};
+    memcpy(header.magic, DFA_FILE_MAGIC, sizeof(header.magic));
+    header.version = DFA_FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numStates = n;
+    header.width = dfa.AlphabetWidth();
+    header.startState = dfa.Start();
+    header.flags = prefilter.Enabled() ? DFA_FILE_PREFILTER : 0;
+    header.literalLength = prefilter.Literal().size();
+    header.prefilterOffset = sizeof(DFAFileHeader) + 256;
+    header.tableOffset = Align8(header.prefilterOffset + 32 + header.literalLength);
+    header.acceptOffset = Align8(header.tableOffset + n * header.width * sizeof(uint32_t));
+    header.tagsOffset = Align8(header.acceptOffset + (n + 63) / 64 * sizeof(uint64_t));
+    header.fileSize = Align8(header.tagsOffset + n * sizeof(int32_t));
+
+    string image(header.fileSize, '\0');
+    uint8_t firstBits[32] = {};
+    for (int b = 0; b < 256; b++)
+        if (prefilter.Enabled() && prefilter.IsFirstByte(b))
+            firstBits[b >> 3] |= 1 << (b & 7);
+
+    memcpy(&image[0], &header, sizeof(header));
+    memcpy(&image[sizeof(header)], dfa.ByteClasses(), 256);
+    memcpy(&image[header.prefilterOffset], firstBits, sizeof(firstBits));
+    memcpy(&image[header.prefilterOffset + 32], prefilter.Literal().data(), header.literalLength);
+    memcpy(&image[header.tableOffset], dfa.Table(), n * header.width * sizeof(uint32_t));
+    memcpy(&image[header.acceptOffset], dfa.AcceptBits(), (n + 63) / 64 * sizeof(uint64_t));
+    memcpy(&image[header.tagsOffset], dfa.AcceptTags(), n * sizeof(int32_t));
+
+    ofstream file(path, ios::binary);
+    if (!file.is_open() || !file.write(image.data(), image.size()))
+        throw runtime_error("could not write DFA file " + path);
+}
+
+//---------------------------------------------------------------------------------
+// map the file and build a CompiledDFA that views it. the mapping lives as
+// long as the returned DFA and any copy of it
+//---------------------------------------------------------------------------------
+shared_ptr<const CompiledDFA> LoadDFA(const string &path, bool verify)
+{
+    auto file = make_shared<MappedFile>(path, false);
+    if (!file->IsOpen())
+        throw runtime_error("could not open DFA file " + path);
+
+    string_view data = file->Data();
+    auto Corrupt = [&path](const string &why) { return runtime_error("bad DFA file " + path + ": " + why); };
+
+    DFAFileHeader header;
+    if (data.size() < sizeof(header) + 256)
+        throw Corrupt("too short");
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, DFA_FILE_MAGIC, sizeof(header.magic)) != 0)
+        throw Corrupt("not a DFA file");
+    if (header.byteOrder != BYTE_ORDER_MARK)
+        throw Corrupt("written with a different byte order");
+    if (header.version != DFA_FILE_VERSION)
+        throw Corrupt("unsupported version " + to_string(header.version));
+
+    uint64_t n = header.numStates;
+    auto Section = [&](uint64_t offset, uint64_t bytes) {
+        if (offset % 8 != 0 || offset > data.size() || bytes > data.size() - offset)
+            throw Corrupt("section out of bounds");
+        return data.data() + offset;
+    };
+    if (header.fileSize != data.size() || n == 0 || header.width == 0 || header.width > 256 ||
+        header.startState >= n)
+        throw Corrupt("inconsistent header");
+    // Next and LongestMatch index the table with state * width in 32 bits
+    if (n * header.width > UINT32_MAX)
+        throw Corrupt("transition table has more than 2^32 entries");
+
+    const uint8_t *classes = reinterpret_cast<const uint8_t *>(data.data() + sizeof(header));
+    const uint8_t *firstBits = reinterpret_cast<const uint8_t *>(Section(header.prefilterOffset, 32 + header.literalLength));
+    auto table = reinterpret_cast<const uint32_t *>(Section(header.tableOffset, n * header.width * sizeof(uint32_t)));
+    auto accept = reinterpret_cast<const uint64_t *>(Section(header.acceptOffset, (n + 63) / 64 * sizeof(uint64_t)));
+    auto tags = reinterpret_cast<const int *>(Section(header.tagsOffset, n * sizeof(int32_t)));
+
+    for (int b = 0; b < 256; b++)
+        if (classes[b] >= header.width)
+            throw Corrupt("byte class out of range");
+    if (verify)
+        for (uint64_t i = 0; i < n * header.width; i++)
+            if (table[i] != CompiledDFA::DEAD && table[i] >= n)
+                throw Corrupt("transition out of range");
+
+    auto dfa = make_shared<CompiledDFA>(header.numStates, header.width, header.startState, classes, table,
+                                        accept, tags, file);
+    if (header.flags & DFA_FILE_PREFILTER)
+    {
+        array<bool, 256> first;
+        for (int b = 0; b < 256; b++)
+            first[b] = (firstBits[b >> 3] >> (b & 7)) & 1;
+        dfa->setPrefilter(Prefilter(first, string(reinterpret_cast<const char *>(firstBits) + 32, header.literalLength)));
+    }
+    return dfa;
+}
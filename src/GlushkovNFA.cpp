@@ -0,0 +1,134 @@
+#include <stdexcept>
+#include <cctype>
+#include "../include/GlushkovNFA.h"
+
+size_t GlushkovNFA::CountPositions(const string &postfix)
+{
+    size_t count = 0;
+    for (char c : postfix)
+        if (isalpha(c))
+            count++;
+    return count;
+}
+
+//---------------------------------------------------------------------------------
+// Glushkov construction over the postfix. every subexpression carries whether
+// it is nullable and the masks of the positions it can start and end with;
+// concatenation and star add follow edges from the last positions of one
+// side to the first positions of the other
+//---------------------------------------------------------------------------------
+struct GlushkovInfo
+{
+    bool nullable;
+    uint64_t first;
+    uint64_t last;
+};
+
+GlushkovNFA::GlushkovNFA(const string &postfix) : numPositions(CountPositions(postfix)), byte_mask{}, finals(0)
+{
+    if (numPositions > MAX_POSITIONS)
+        throw invalid_argument("regex has " + to_string(numPositions) + " symbols, the bit-parallel engine takes at most " +
+                               to_string(MAX_POSITIONS));
+
+    vector<uint64_t> follow(numPositions + 1, 0);
+    vector<GlushkovInfo> stack;
+    auto Pop = [&]() {
+        if (stack.empty())
+            throw invalid_argument("malformed regex: operator is missing an operand");
+        GlushkovInfo top = stack.back();
+        stack.pop_back();
+        return top;
+    };
+    auto AddFollow = [&](uint64_t from, uint64_t to) {
+        for (size_t p = 0; p <= numPositions; p++)
+            if (from >> p & 1)
+                follow[p] |= to;
+    };
+
+    size_t position = 0;
+    for (char c : postfix)
+    {
+        if (isalpha(c))
+        {
+            uint64_t bit = uint64_t(1) << ++position;
+            byte_mask[(unsigned char)c] |= bit;
+            stack.push_back({false, bit, bit});
+        }
+        else if (c == '*')
+        {
+            GlushkovInfo inner = Pop();
+            AddFollow(inner.last, inner.first);
+            inner.nullable = true;
+            stack.push_back(inner);
+        }
+        else if (c == '.')
+        {
+            GlushkovInfo right = Pop();
+            GlushkovInfo left = Pop();
+            AddFollow(left.last, right.first);
+            stack.push_back({left.nullable && right.nullable, left.nullable ? left.first | right.first : left.first,
+                             right.nullable ? left.last | right.last : right.last});
+        }
+        else if (c == '|')
+        {
+            GlushkovInfo right = Pop();
+            GlushkovInfo left = Pop();
+            stack.push_back({left.nullable || right.nullable, left.first | right.first, left.last | right.last});
+        }
+    }
+    if (stack.size() != 1)
+        throw invalid_argument(stack.empty() ? "malformed regex: no operands"
+                                             : "malformed regex: operands without an operator");
+
+    // the start state leads to the first positions and accepts the empty string
+    follow[0] = stack.back().first;
+    finals = stack.back().last | (stack.back().nullable ? 1 : 0);
+
+    // follow_tables[k][b] is the union of follow[8k + j] over the bits j set in b
+    follow_tables.assign((numPositions + 1 + 7) / 8, {});
+    for (size_t chunk = 0; chunk < follow_tables.size(); chunk++)
+    {
+        for (int bits = 1; bits < 256; bits++)
+        {
+            int low = __builtin_ctz(bits);
+            size_t p = chunk * 8 + low;
+            uint64_t own = p <= numPositions ? follow[p] : 0;
+            follow_tables[chunk][bits] = follow_tables[chunk][bits & (bits - 1)] | own;
+        }
+    }
+}
+
+size_t GlushkovNFA::LongestMatch(string_view text, size_t pos) const
+{
+    uint64_t active = 1;
+    size_t last = (finals & 1) ? pos : NO_MATCH;
+    for (size_t i = pos; i < text.size(); i++)
+    {
+        active = Follow(active) & byte_mask[(unsigned char)text[i]];
+        if (!active)
+            break;
+        if (active & finals)
+            last = i + 1;
+    }
+    return last;
+}
+
+bool GlushkovNFA::matches(string_view text) const
+{
+    return LongestMatch(text, 0) == text.size();
+}
+
+bool GlushkovNFA::search(string_view text, MatchSpan &match) const
+{
+    return SearchLoop([this](string_view t, size_t pos) { return LongestMatch(t, pos); }, prefilter, text, match);
+}
+
+size_t GlushkovNFA::find_all(string_view text, const function<void(size_t, size_t)> &callback) const
+{
+    return FindAllLoop([this](string_view t, size_t pos) { return LongestMatch(t, pos); }, prefilter, text, callback);
+}
+
+size_t GlushkovNFA::MemoryBytes() const
+{
+    return sizeof(*this) + follow_tables.capacity() * sizeof(follow_tables[0]);
+}
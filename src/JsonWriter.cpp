@@ -0,0 +1,213 @@
+#include <charconv>
+#include "../include/JsonWriter.h"
+
+JsonWriter::JsonWriter(ostream &out, int indent) : out(out), indent(indent), afterKey(false)
+{
+    buffer.reserve(BUFFER_BYTES);
+}
+
+JsonWriter::~JsonWriter()
+{
+    Flush();
+}
+
+void JsonWriter::Flush()
+{
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void JsonWriter::Newline()
+{
+    if (indent < 0)
+        return;
+    Append('\n');
+    for (size_t spaces = empty.size() * indent; spaces > 0;)
+    {
+        static const char blanks[] = "                                ";
+        size_t n = min(spaces, sizeof(blanks) - 1);
+        Append(string_view(blanks, n));
+        spaces -= n;
+    }
+}
+
+//---------------------------------------------------------------------------------
+// a value either follows its key or starts a new element of the innermost
+// container, after a comma unless it is the first one
+//---------------------------------------------------------------------------------
+void JsonWriter::BeforeValue()
+{
+    if (afterKey)
+    {
+        afterKey = false;
+        return;
+    }
+    if (empty.empty())
+        return;
+    if (!empty.back())
+        Append(',');
+    empty.back() = false;
+    Newline();
+}
+
+void JsonWriter::Close(char bracket)
+{
+    bool wasEmpty = empty.back();
+    empty.pop_back();
+    if (!wasEmpty)
+        Newline();
+    Append(bracket);
+}
+
+void JsonWriter::BeginObject()
+{
+    BeforeValue();
+    Append('{');
+    empty.push_back(true);
+}
+
+void JsonWriter::EndObject()
+{
+    Close('}');
+}
+
+void JsonWriter::BeginArray()
+{
+    BeforeValue();
+    Append('[');
+    empty.push_back(true);
+}
+
+void JsonWriter::EndArray()
+{
+    Close(']');
+}
+
+void JsonWriter::Key(string_view key)
+{
+    BeforeValue();
+    Quote(key);
+    Append(indent < 0 ? ":" : ": ");
+    afterKey = true;
+}
+
+void JsonWriter::String(string_view value)
+{
+    BeforeValue();
+    Quote(value);
+}
+
+//---------------------------------------------------------------------------------
+// length of the well-formed UTF-8 sequence at value[i], a byte >= 0x80, or 0
+// if it is not one: overlong forms, surrogates and code points past U+10FFFF
+// are rejected as dump() rejects them
+//---------------------------------------------------------------------------------
+static size_t Utf8Length(string_view value, size_t i)
+{
+    unsigned char c = value[i];
+    size_t length;
+    unsigned char low = 0x80, high = 0xBF; // the range of the second byte
+    if (c >= 0xC2 && c <= 0xDF)
+        length = 2;
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+        length = 3;
+        low = c == 0xE0 ? 0xA0 : low;
+        high = c == 0xED ? 0x9F : high;
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+        length = 4;
+        low = c == 0xF0 ? 0x90 : low;
+        high = c == 0xF4 ? 0x8F : high;
+    }
+    else
+        return 0;
+    if (value.size() - i < length)
+        return 0;
+    for (size_t k = 1; k < length; k++)
+    {
+        unsigned char next = value[i + k];
+        if (next < (k == 1 ? low : 0x80) || next > (k == 1 ? high : 0xBF))
+            return 0;
+    }
+    return length;
+}
+
+//---------------------------------------------------------------------------------
+// a string literal. runs of bytes that need no escaping are copied at once;
+// UTF-8 passes through unchanged. a byte that is not part of valid UTF-8 is
+// written as \u00XX, its Latin-1 reading, so the output is always valid JSON
+// where dump() would throw
+//---------------------------------------------------------------------------------
+void JsonWriter::Quote(string_view value)
+{
+    Append('"');
+    size_t run = 0; // start of the bytes that need no escaping
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        unsigned char c = value[i];
+        if (c >= 0x80)
+        {
+            size_t length = Utf8Length(value, i);
+            if (length)
+            {
+                i += length - 1;
+                continue;
+            }
+        }
+        else if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        Append(value.substr(run, i - run));
+        run = i + 1;
+        switch (c)
+        {
+        case '"': Append("\\\""); break;
+        case '\\': Append("\\\\"); break;
+        case '\n': Append("\\n"); break;
+        case '\t': Append("\\t"); break;
+        case '\r': Append("\\r"); break;
+        case '\b': Append("\\b"); break;
+        case '\f': Append("\\f"); break;
+        default:
+        {
+            static const char hex[] = "0123456789abcdef";
+            char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+            Append(string_view(escape, sizeof(escape)));
+        }
+        }
+    }
+    Append(value.substr(run));
+    Append('"');
+}
+
+void JsonWriter::Int(long long value)
+{
+    BeforeValue();
+    char digits[24];
+    char *end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    Append(string_view(digits, end - digits));
+}
+
+void JsonWriter::Raw(string_view json)
+{
+    BeforeValue();
+    if (indent < 0)
+    {
+        Append(json);
+        return;
+    }
+    string padding(empty.size() * indent, ' ');
+    for (size_t start = 0; start < json.size();)
+    {
+        size_t line = json.find('\n', start);
+        if (line == string_view::npos)
+        {
+            Append(json.substr(start));
+            break;
+        }
+        Append(json.substr(start, line + 1 - start));
+        Append(padding);
+        start = line + 1;
+    }
+}
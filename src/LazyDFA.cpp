@@ -0,0 +1,237 @@
+#include <algorithm>
+#include "../include/LazyDFA.h"
+
+//---------------------------------------------------------------------------------
+// LazyDFA ctor: split the edges into epsilon and per-class lists, cache the
+// start state. nothing quadratic in the NFA size is built
+//---------------------------------------------------------------------------------
+LazyDFA::LazyDFA(const NFA &nfa, const LazyDFAOptions &opts)
+    : options(opts), numNFAStates(nfa.NumStates()), epsilons(numNFAStates), edges(numNFAStates),
+      finals(numNFAStates), flushes(0)
+{
+    options.max_states = max<size_t>(options.max_states, 2);
+
+    // Every alphabet symbol gets its own class, class 0 never matches
+    byte_class.fill(0);
+    width = 1;
+    for (char a : nfa.getAlpha())
+        if (a != '_')
+            byte_class[(unsigned char)a] = width++;
+
+    const NFAArena &arena = nfa.getArena();
+    for (int s = 0; s < arena.NumStates(); s++)
+        for (const NFAEdge *e = arena.EdgesBegin(s); e != arena.EdgesEnd(s); e++)
+            if (e->sym == '_')
+                epsilons[s].push_back(e->dst);
+            else if (byte_class[(unsigned char)e->sym] != 0)
+                edges[s].push_back({byte_class[(unsigned char)e->sym], e->dst});
+
+    for (int s : nfa.getFinalStates())
+        finals.Insert(s);
+    startSet = StateSet(numNFAStates);
+    AddClosure(nfa.getInitState(), startSet);
+    AddState(startSet);
+}
+
+//---------------------------------------------------------------------------------
+// add a state set to the cache, its transitions are all unknown
+//---------------------------------------------------------------------------------
+uint32_t LazyDFA::AddState(const StateSet &set)
+{
+    uint32_t id = sets.size();
+    auto inserted = ids.emplace(set, id);
+    sets.push_back(&inserted.first->first);
+    trans.resize(trans.size() + width, UNKNOWN);
+    trans[id * width] = DEAD; // class 0
+    accepting.push_back(set.Intersects(finals));
+    return id;
+}
+
+//---------------------------------------------------------------------------------
+// drop every cached state except the start state, which keeps id 0
+//---------------------------------------------------------------------------------
+void LazyDFA::Flush()
+{
+    ids.clear();
+    sets.clear();
+    trans.clear();
+    accepting.clear();
+    flushes++;
+    AddState(startSet);
+}
+
+//---------------------------------------------------------------------------------
+// add the epsilon closure of state to out. states already in out are not
+// walked again, so one Successor call visits every NFA state at most once
+//---------------------------------------------------------------------------------
+void LazyDFA::AddClosure(int state, StateSet &out)
+{
+    if (out.Contains(state))
+        return;
+    out.Insert(state);
+    pending.push_back(state);
+    while (!pending.empty())
+    {
+        int s = pending.back();
+        pending.pop_back();
+        for (int dst : epsilons[s])
+        {
+            if (!out.Contains(dst))
+            {
+                out.Insert(dst);
+                pending.push_back(dst);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------
+// epsilon closure of move(from, class), the same set NFA::EpsilonClosure(NFA::move())
+// would give. out is reused when it already has the right size
+//---------------------------------------------------------------------------------
+void LazyDFA::Successor(const StateSet &from, int cls, StateSet &out)
+{
+    if (out.Words().size() == startSet.Words().size())
+        out.Clear();
+    else
+        out = StateSet(numNFAStates);
+    from.ForEach([&](int s) {
+        for (const auto &edge : edges[s])
+            if (edge.first == cls)
+                AddClosure(edge.second, out);
+    });
+}
+
+//---------------------------------------------------------------------------------
+// fill in an unknown transition. when the cache is full this either flushes
+// it or hands the successor back in offCache and returns OFF_CACHE
+//---------------------------------------------------------------------------------
+uint32_t LazyDFA::Compute(uint32_t state, int cls, StateSet &offCache)
+{
+    StateSet &next = scratch;
+    Successor(*sets[state], cls, next);
+    if (next.Empty())
+    {
+        trans[state * width + cls] = DEAD;
+        return DEAD;
+    }
+
+    auto found = ids.find(next);
+    if (found != ids.end())
+    {
+        trans[state * width + cls] = found->second;
+        return found->second;
+    }
+
+    if (sets.size() < options.max_states)
+    {
+        uint32_t id = AddState(next);
+        trans[state * width + cls] = id;
+        return id;
+    }
+
+    if (options.fallback_to_nfa)
+    {
+        offCache = next;
+        return OFF_CACHE;
+    }
+
+    // state is gone after the flush, only its successor is needed
+    Flush();
+    found = ids.find(next);
+    return found != ids.end() ? found->second : AddState(next);
+}
+
+//---------------------------------------------------------------------------------
+// end of the longest match anchored at pos, NO_MATCH if there is none.
+// runs on cached transitions and drops to plain NFA simulation while the
+// current state set is not in a full cache
+//---------------------------------------------------------------------------------
+size_t LazyDFA::LongestMatch(string_view text, size_t pos)
+{
+    uint32_t state = 0;
+    bool offCache = false;
+    StateSet current, next;
+    size_t last = accepting[0] ? pos : NO_MATCH;
+
+    for (size_t i = pos; i < text.size(); i++)
+    {
+        int cls = byte_class[(unsigned char)text[i]];
+        bool accept;
+        if (!offCache)
+        {
+            uint32_t target = trans[state * width + cls];
+            if (target == UNKNOWN)
+                target = Compute(state, cls, current);
+            if (target == DEAD)
+                break;
+            if (target == OFF_CACHE)
+            {
+                offCache = true;
+                accept = current.Intersects(finals);
+            }
+            else
+            {
+                state = target;
+                accept = accepting[state];
+            }
+        }
+        else
+        {
+            Successor(current, cls, next);
+            if (next.Empty())
+                break;
+            swap(current, next);
+            auto found = ids.find(current);
+            if (found != ids.end())
+            {
+                offCache = false; // back on cached states
+                state = found->second;
+            }
+            accept = current.Intersects(finals);
+        }
+        if (accept)
+            last = i + 1;
+    }
+    return last;
+}
+
+//---------------------------------------------------------------------------------
+// does the whole of text match
+//---------------------------------------------------------------------------------
+bool LazyDFA::matches(string_view text)
+{
+    return LongestMatch(text, 0) == text.size();
+}
+
+//---------------------------------------------------------------------------------
+// leftmost-longest match anywhere in text
+//---------------------------------------------------------------------------------
+bool LazyDFA::search(string_view text, MatchSpan &match)
+{
+    return SearchLoop([this](string_view t, size_t pos) { return LongestMatch(t, pos); }, prefilter, text, match);
+}
+
+//---------------------------------------------------------------------------------
+// every non-overlapping leftmost-longest match, returns the count
+//---------------------------------------------------------------------------------
+size_t LazyDFA::find_all(string_view text, const function<void(size_t, size_t)> &callback)
+{
+    return FindAllLoop([this](string_view t, size_t pos) { return LongestMatch(t, pos); }, prefilter, text, callback);
+}
+
+//---------------------------------------------------------------------------------
+// the NFA's edge lists and the working sets plus a full cache: every cached
+// state costs its transition row and one state set key
+//---------------------------------------------------------------------------------
+size_t LazyDFA::MemoryBytes() const
+{
+    size_t setBytes = startSet.Words().size() * sizeof(uint64_t) + sizeof(StateSet);
+    size_t bytes = sizeof(*this) + 3 * setBytes + numNFAStates * sizeof(int); // finals, start, scratch, stack
+    for (const auto &stateEdges : edges)
+        bytes += sizeof(stateEdges) + stateEdges.capacity() * sizeof(stateEdges[0]);
+    for (const auto &stateEpsilons : epsilons)
+        bytes += sizeof(stateEpsilons) + stateEpsilons.capacity() * sizeof(stateEpsilons[0]);
+    size_t perState = width * sizeof(uint32_t) + setBytes + sizeof(const StateSet *) + 2 * sizeof(void *);
+    return bytes + options.max_states * perState;
+}
@@ -0,0 +1,55 @@
+#include <fstream>
+#include <iterator>
+#include "../include/MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAVE_MMAP 1
+#endif
+
+//---------------------------------------------------------------------------------
+// map the file, or read it if mapping is not possible
+//---------------------------------------------------------------------------------
+MappedFile::MappedFile(const string &path, bool sequential) : open(false), mapped(false), data(nullptr), size(0)
+{
+#ifdef HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                madvise(addr, st.st_size, sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+                data = static_cast<const char *>(addr);
+                size = st.st_size;
+                mapped = true;
+                open = true;
+            }
+        }
+        ::close(fd);
+        if (open)
+            return;
+    }
+#endif
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+        return;
+    buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+    open = true;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef HAVE_MMAP
+    if (mapped)
+        munmap(const_cast<char *>(data), size);
+#endif
+}
@@ -0,0 +1,64 @@
+#include "../include/MultiPattern.h"
+#include "converter.hpp"
+
+//---------------------------------------------------------------------------------
+// MultiPattern ctor: one NFA for all patterns, one subset construction
+//---------------------------------------------------------------------------------
+MultiPattern::MultiPattern(const vector<string> &patterns, const CompileLimits &limits) : sources(patterns)
+{
+    map<int, int> thompsonTags, finalTags;
+    NFA thompson = PatternsToNFA(patterns, thompsonTags);
+    NFA nfa = RemoveEpsilons(thompson, thompsonTags, finalTags, nullptr, EpsilonEdgeBudget(thompson));
+    table = make_shared<const CompiledDFA>(NFAtoCompiledDFA(nfa, finalTags, limits));
+}
+
+//---------------------------------------------------------------------------------
+// longest match anchored at pos and the pattern it belongs to
+//---------------------------------------------------------------------------------
+size_t MultiPattern::LongestMatch(string_view text, size_t pos, int &pattern) const
+{
+    uint32_t state = table->Start();
+    size_t last = NO_MATCH;
+    pattern = -1;
+    if (table->IsAccepting(state))
+    {
+        last = pos;
+        pattern = table->AcceptTag(state);
+    }
+
+    for (size_t i = pos; i < text.size(); i++)
+    {
+        state = table->Next(state, text[i]);
+        if (state == CompiledDFA::DEAD)
+            break;
+        if (table->IsAccepting(state))
+        {
+            last = i + 1;
+            pattern = table->AcceptTag(state);
+        }
+    }
+    return last;
+}
+
+//---------------------------------------------------------------------------------
+// tokenize text in a single pass per token
+//---------------------------------------------------------------------------------
+size_t MultiPattern::Scan(string_view text, const function<void(int, size_t, size_t)> &callback) const
+{
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        int pattern;
+        size_t end = LongestMatch(text, pos, pattern);
+        if (end == NO_MATCH || end == pos)
+        {
+            pos++; // no token starts here
+            continue;
+        }
+        callback(pattern, pos, end);
+        count++;
+        pos = end;
+    }
+    return count;
+}
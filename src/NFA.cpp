@@ -4,8 +4,69 @@
 #include <queue>
 #include <stack>
 #include <string>
+#include <algorithm>
 using namespace std;
 #include "../include/NFA.h"
+#include "../include/NFABuilder.h"
+
+//---------------------------------------------------------------------------------
+// NFA ctor, no transitions yet
+//---------------------------------------------------------------------------------
+NFA::NFA(set<char> A, int I, set<int> F)
+    : Narena(make_shared<NFAArena>()), alphabet(A), init_state(I), fin_states(F)
+{
+}
+
+//---------------------------------------------------------------------------------
+// every edge of an arena as (src, dst, sym)
+//---------------------------------------------------------------------------------
+static vector<NFABuilderEdge> CollectEdges(const NFAArena &arena)
+{
+    vector<NFABuilderEdge> edges;
+    edges.reserve(arena.edges.size());
+    for (int s = 0; s < arena.NumStates(); s++)
+        for (const NFAEdge *e = arena.EdgesBegin(s); e != arena.EdgesEnd(s); e++)
+            edges.push_back({s, e->dst, e->sym});
+    return edges;
+}
+
+//---------------------------------------------------------------------------------
+// rebuild an arena from a list of edges, sized to fit every state mentioned
+//---------------------------------------------------------------------------------
+static shared_ptr<const NFAArena> RebuildArena(vector<NFABuilderEdge> &edges)
+{
+    int numStates = 0;
+    for (const auto &e : edges)
+        numStates = max(numStates, max(e.src, e.dst) + 1);
+    return NFABuilder::BuildArena(numStates, edges);
+}
+
+//---------------------------------------------------------------------------------
+// replace the transitions of src on sym. this rebuilds the arena and is
+// only meant for small hand-built NFAs, NFABuilder is the fast path
+//---------------------------------------------------------------------------------
+void NFA::AddTransition(int src, set<int> dst, char sym)
+{
+    vector<NFABuilderEdge> edges = CollectEdges(*Narena);
+    edges.erase(remove_if(edges.begin(), edges.end(),
+                          [&](const NFABuilderEdge &e) { return e.src == src && e.sym == sym; }),
+                edges.end());
+    for (int d : dst)
+        edges.push_back({src, d, sym});
+    Narena = RebuildArena(edges);
+}
+
+//---------------------------------------------------------------------------------
+// the transitions as nested maps, used for JSON export
+//---------------------------------------------------------------------------------
+map<int, map<char, set<int>>> NFA::getNFATransitions() const
+{
+    map<int, map<char, set<int>>> Ntran;
+    for (int s = 0; s < Narena->NumStates(); s++)
+        for (const NFAEdge *e = Narena->EdgesBegin(s); e != Narena->EdgesEnd(s); e++)
+            Ntran[s][e->sym].insert(e->dst);
+    return Ntran;
+}
 
 //---------------------------------------------------------------------------------
 // print the NFA
@@ -13,14 +74,19 @@ using namespace std;
 void NFA::Print()
 {
     cout << "NFA Transitions:\n";
-    for (const auto &nfa_row : Ntran)
+    for (int s = 0; s < Narena->NumStates(); s++)
     {
-        cout << nfa_row.first << ":\t";
-        for (const auto &transition : nfa_row.second)
+        const NFAEdge *e = Narena->EdgesBegin(s);
+        const NFAEdge *end = Narena->EdgesEnd(s);
+        if (e == end)
+            continue;
+        cout << s << ":\t";
+        while (e != end)
         {
-            cout << transition.first << ": { ";
-            for (int state : transition.second)
-                cout << state << " ";
+            char sym = e->sym;
+            cout << sym << ": { ";
+            for (; e != end && e->sym == sym; e++)
+                cout << e->dst << " ";
             cout << "} ";
         }
         cout << endl;
@@ -42,17 +108,13 @@ set<int> NFA::EpsilonClosureState(int state) const {
         int curr = stack.top(); stack.pop();
 
         // Check if there are any epsilon transitions from current state
-        auto iterator = Ntran.find(curr);
-        if (iterator != Ntran.end()) {
-            auto epsilon_transition = iterator->second.find('_'); // Try to find current state in NFA's transition map
-            if (epsilon_transition != iterator->second.end()) { // If there are ε-transitions
-                // Process each state reachable by ε-transitions
-                for (int next : epsilon_transition->second) {
-                    if (epsilon_closure.find(next) == epsilon_closure.end()) {
-                        epsilon_closure.insert(next);
-                        stack.push(next);
-                    }
-                }
+        if (curr >= Narena->NumStates())
+            continue;
+        for (const NFAEdge *e = Narena->EdgesBegin(curr); e != Narena->EdgesEnd(curr); e++) {
+            // Process each state reachable by ε-transitions
+            if (e->sym == '_' && epsilon_closure.find(e->dst) == epsilon_closure.end()) {
+                epsilon_closure.insert(e->dst);
+                stack.push(e->dst);
             }
         }
     }
@@ -73,6 +135,106 @@ set<int> NFA::EpsilonClosure(const set<int>& states) const {
     return closure;
 }
 
+//---------------------------------------------------------------------------------
+// number of state ids in use, i.e. one more than the largest state id
+//---------------------------------------------------------------------------------
+int NFA::NumStates() const
+{
+    int numStates = max(Narena->NumStates(), init_state + 1);
+    for (int s : fin_states)
+        numStates = max(numStates, s + 1);
+    for (const NFAEdge &e : Narena->edges)
+        numStates = max(numStates, e.dst + 1);
+    return numStates;
+}
+
+//---------------------------------------------------------------------------------
+// false once RemoveEpsilons has run: every closure is the state itself
+//---------------------------------------------------------------------------------
+bool NFA::HasEpsilons() const
+{
+    for (const NFAEdge &e : Narena->edges)
+        if (e.sym == '_')
+            return true;
+    return false;
+}
+
+//---------------------------------------------------------------------------------
+// epsilon closure of every state at once, as bitsets indexed by state.
+// Tarjan's algorithm finds the strongly connected components of the
+// epsilon graph in reverse topological order, so each component's closure
+// is its members plus the already finished closures of its successors
+//---------------------------------------------------------------------------------
+vector<StateSet> NFA::EpsilonClosures() const
+{
+    int n = NumStates();
+    vector<vector<int>> eps(n);
+    for (int s = 0; s < Narena->NumStates(); s++)
+        for (const NFAEdge *e = Narena->EdgesBegin(s); e != Narena->EdgesEnd(s); e++)
+            if (e->sym == '_')
+                eps[s].push_back(e->dst);
+
+    vector<StateSet> closures(n);
+    vector<int> index(n, -1), low(n, 0), component(n, -1);
+    vector<int> sccStack;
+    vector<pair<int, size_t>> callStack; // (state, next edge to visit)
+    int counter = 0;
+
+    for (int root = 0; root < n; root++)
+    {
+        if (index[root] >= 0)
+            continue;
+        callStack.push_back({root, 0});
+        index[root] = low[root] = counter++;
+        sccStack.push_back(root);
+
+        while (!callStack.empty())
+        {
+            int v = callStack.back().first;
+            size_t &edge = callStack.back().second;
+            if (edge < eps[v].size())
+            {
+                int w = eps[v][edge++];
+                if (index[w] < 0)
+                {
+                    index[w] = low[w] = counter++;
+                    sccStack.push_back(w);
+                    callStack.push_back({w, 0});
+                }
+                else if (component[w] < 0)
+                    low[v] = min(low[v], index[w]); // w is still on the stack
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty())
+                low[callStack.back().first] = min(low[callStack.back().first], low[v]);
+            if (low[v] != index[v])
+                continue;
+
+            // v is the root of a component: pop it and build its closure
+            StateSet closure(n);
+            size_t top = sccStack.size();
+            do
+                top--;
+            while (sccStack[top] != v);
+            for (size_t i = top; i < sccStack.size(); i++)
+            {
+                closure.Insert(sccStack[i]);
+                component[sccStack[i]] = v;
+            }
+            for (size_t i = top; i < sccStack.size(); i++)
+                for (int w : eps[sccStack[i]])
+                    if (component[w] != v)
+                        closure.UnionWith(closures[w]);
+            for (size_t i = top; i < sccStack.size(); i++)
+                closures[sccStack[i]] = closure;
+            sccStack.resize(top);
+        }
+    }
+    return closures;
+}
+
 //---------------------------------------------------------------------------------
 // move operation for the NFA
 // returns the set of states reachable from a set of states on a given symbol
@@ -83,17 +245,12 @@ set<int> NFA::move(const set<int> &T, char symbol) const
     for (int state : T)
     {
         // Check if there is any transition from state
-        auto iterator = Ntran.find(state);
-        if (iterator != Ntran.end())
-        {
-            // Check if a transition exists on the given symbol
-            auto transIterator = iterator->second.find(symbol);
-            if (transIterator != iterator->second.end())
-            {
-                // Insert all destination states into result
-                result.insert(transIterator->second.begin(), transIterator->second.end());
-            }
-        }
+        if (state >= Narena->NumStates())
+            continue;
+        // Insert all destination states on the given symbol into result
+        for (const NFAEdge *e = Narena->EdgesBegin(state); e != Narena->EdgesEnd(state); e++)
+            if (e->sym == symbol)
+                result.insert(e->dst);
     }
     return result;
 }
@@ -104,17 +261,12 @@ set<int> NFA::move(const set<int> &T, char symbol) const
 //---------------------------------------------------------------------------------
 void NFA::Merge(const NFA &nfaToMerge)
 {
-    // Copy each transition from other NFA
-    for (auto &row : nfaToMerge.Ntran)
-    {
-        int src = row.first;
-        for (auto &trans : row.second)
-        {
-            char sym = trans.first;
-            // Add new destination states to any existing transitions
-            Ntran[src][sym].insert(trans.second.begin(), trans.second.end());
-        }
-    }
+    // Copy each transition from both NFAs, the arena drops duplicates
+    vector<NFABuilderEdge> edges = CollectEdges(*Narena);
+    vector<NFABuilderEdge> other = CollectEdges(*nfaToMerge.Narena);
+    edges.insert(edges.end(), other.begin(), other.end());
+    Narena = RebuildArena(edges);
+
     // Merge the alphabets
     alphabet.insert(nfaToMerge.alphabet.begin(), nfaToMerge.alphabet.end());
 }
@@ -124,25 +276,14 @@ void NFA::Merge(const NFA &nfaToMerge)
 //---------------------------------------------------------------------------------
 void NFA::ShiftStates(int offset)
 {
-    map<int, map<char, set<int>>> newNtran;
-    // Process each row in the current transition map
-    for (const auto &row : Ntran)
+    vector<NFABuilderEdge> edges = CollectEdges(*Narena);
+    // Shift the source and destination of each transition by offset
+    for (auto &e : edges)
     {
-        int newSrc = row.first + offset; // Shift the current state by offset
-        // Process each transition from this state
-        for (const auto &trans : row.second)
-        {
-            char sym = trans.first;
-            set<int> newDst;
-            // Shift each state transition by offset
-            for (int dest : trans.second)
-            {
-                newDst.insert(dest + offset);
-            }
-            newNtran[newSrc][sym] = newDst;
-        }
+        e.src += offset;
+        e.dst += offset;
     }
-    Ntran = newNtran;
+    Narena = RebuildArena(edges);
     init_state += offset;
 
     set<int> newFinStates;
@@ -152,4 +293,4 @@ void NFA::ShiftStates(int offset)
         newFinStates.insert(s + offset);
     }
     fin_states = newFinStates;
-}
\ No newline at end of file
+}
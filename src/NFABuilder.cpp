@@ -0,0 +1,134 @@
+#include <algorithm>
+#include "../include/NFABuilder.h"
+
+//---------------------------------------------------------------------------------
+// append an edge, symbols other than epsilon join the alphabet
+//---------------------------------------------------------------------------------
+void NFABuilder::AddEdge(int src, int dst, char sym)
+{
+    pending.push_back({src, dst, sym});
+    if (sym != '_')
+        alphabet[(unsigned char)sym] = true;
+}
+
+//---------------------------------------------------------------------------------
+// start --c--> end
+//---------------------------------------------------------------------------------
+NFAFragment NFABuilder::Symbol(char c)
+{
+    int start = AddState();
+    int end = AddState();
+    AddEdge(start, end, c);
+    return {start, end};
+}
+
+//---------------------------------------------------------------------------------
+// first.end --ε--> second.start
+//---------------------------------------------------------------------------------
+NFAFragment NFABuilder::Concat(NFAFragment first, NFAFragment second)
+{
+    AddEdge(first.end, second.start, '_');
+    return {first.start, second.end};
+}
+
+//---------------------------------------------------------------------------------
+// new start and final state, ε-transitions from the new start and from the
+// inner final state to both the inner start state and the new final state
+//---------------------------------------------------------------------------------
+NFAFragment NFABuilder::Star(NFAFragment inner)
+{
+    int start = AddState();
+    int end = AddState();
+    AddEdge(start, inner.start, '_');
+    AddEdge(start, end, '_');
+    AddEdge(inner.end, inner.start, '_');
+    AddEdge(inner.end, end, '_');
+    return {start, end};
+}
+
+//---------------------------------------------------------------------------------
+// new start state with ε-transitions to both fragments, whose final states
+// get ε-transitions to a new final state
+//---------------------------------------------------------------------------------
+NFAFragment NFABuilder::Union(NFAFragment left, NFAFragment right)
+{
+    int start = AddState();
+    int end = AddState();
+    AddEdge(start, left.start, '_');
+    AddEdge(start, right.start, '_');
+    AddEdge(left.end, end, '_');
+    AddEdge(right.end, end, '_');
+    return {start, end};
+}
+
+//---------------------------------------------------------------------------------
+// copy the template's edges shifted to fresh states. the edges of a fragment
+// are appended in the order its states are created, so the copy matches a
+// second construction of the same subexpression state for state
+//---------------------------------------------------------------------------------
+NFAFragment NFABuilder::Clone(const NFATemplate &source)
+{
+    int shift = numStates - source.firstState;
+    numStates += source.numStates;
+    for (size_t i = source.firstEdge; i < source.firstEdge + source.numEdges; i++)
+    {
+        NFABuilderEdge edge = pending[i]; // push_back may move pending
+        pending.push_back({edge.src + shift, edge.dst + shift, edge.sym});
+    }
+    return {source.start + shift, source.end + shift};
+}
+
+//---------------------------------------------------------------------------------
+// freeze the arena and return the NFA of the given fragment
+//---------------------------------------------------------------------------------
+NFA NFABuilder::Finish(NFAFragment whole)
+{
+    shared_ptr<const NFAArena> arena = BuildArena(numStates, pending);
+    pending.clear();
+
+    set<char> symbols;
+    for (int c = 0; c < 256; c++)
+        if (alphabet[c])
+            symbols.insert((char)c);
+    return NFA(arena, symbols, whole.start, {whole.end});
+}
+
+//---------------------------------------------------------------------------------
+// counting sort by source state, then sort and deduplicate each state's edges
+//---------------------------------------------------------------------------------
+shared_ptr<const NFAArena> NFABuilder::BuildArena(int numStates, vector<NFABuilderEdge> &edges)
+{
+    auto arena = make_shared<NFAArena>();
+    vector<uint32_t> &offsets = arena->offsets;
+    offsets.assign(numStates + 1, 0);
+    for (const auto &e : edges)
+        offsets[e.src + 1]++;
+    for (int s = 0; s < numStates; s++)
+        offsets[s + 1] += offsets[s];
+
+    arena->edges.resize(edges.size());
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto &e : edges)
+        arena->edges[fill[e.src]++] = {e.dst, e.sym};
+
+    auto Less = [](const NFAEdge &a, const NFAEdge &b) {
+        return a.sym != b.sym ? a.sym < b.sym : a.dst < b.dst;
+    };
+    uint32_t out = 0;
+    for (int s = 0; s < numStates; s++)
+    {
+        uint32_t begin = offsets[s], end = offsets[s + 1];
+        sort(arena->edges.begin() + begin, arena->edges.begin() + end, Less);
+        offsets[s] = out;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const NFAEdge &e = arena->edges[i];
+            if (out > offsets[s] && arena->edges[out - 1].sym == e.sym && arena->edges[out - 1].dst == e.dst)
+                continue; // duplicate edge
+            arena->edges[out++] = e;
+        }
+    }
+    offsets[numStates] = out;
+    arena->edges.resize(out);
+    return arena;
+}
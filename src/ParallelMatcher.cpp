@@ -0,0 +1,271 @@
+#include <algorithm>
+#include "../include/ParallelMatcher.h"
+
+//---------------------------------------------------------------------------------
+// ParallelMatcher ctor. inputs shorter than two chunks of minChunk bytes
+// run sequentially
+//---------------------------------------------------------------------------------
+ParallelMatcher::ParallelMatcher(const CompiledDFA &dfa, ThreadPool &threads, size_t smallest)
+    : table(dfa), pool(threads), minChunk(max<size_t>(smallest, 1))
+{
+}
+
+//---------------------------------------------------------------------------------
+// a few chunks per worker so uneven chunks even out
+//---------------------------------------------------------------------------------
+size_t ParallelMatcher::ChunkSizeFor(size_t length) const
+{
+    size_t chunks = pool.Size() * 4;
+    size_t chunkSize = (length + chunks - 1) / max<size_t>(chunks, 1);
+    return max(chunkSize, minChunk);
+}
+
+//---------------------------------------------------------------------------------
+// pruned speculation: a chunk can only start in a state some state moves to
+// on the byte just before it
+//---------------------------------------------------------------------------------
+vector<uint32_t> ParallelMatcher::Candidates(unsigned char previous) const
+{
+    vector<uint32_t> states;
+    for (uint32_t s = 0; s < table.NumStates(); s++)
+    {
+        uint32_t next = table.Next(s, previous);
+        if (next != CompiledDFA::DEAD)
+            states.push_back(next);
+    }
+    sort(states.begin(), states.end());
+    states.erase(unique(states.begin(), states.end()), states.end());
+    return states;
+}
+
+//---------------------------------------------------------------------------------
+// simulate a chunk from every start state at once. paths that reach the same
+// state merge, so after a short prefix only a handful of distinct states are
+// stepped per byte
+//---------------------------------------------------------------------------------
+ParallelMatcher::ChunkMap ParallelMatcher::RunChunk(string_view chunk, const vector<uint32_t> &starts) const
+{
+    ChunkMap result;
+    result.from = starts;
+
+    vector<uint32_t> active = starts;     // distinct live states
+    vector<uint32_t> slot(starts.size()); // start state i is now at active[slot[i]]
+    for (size_t i = 0; i < starts.size(); i++)
+        slot[i] = i;
+
+    const size_t MERGE_EVERY = 64;
+    for (size_t pos = 0; pos < chunk.size() && !active.empty(); pos += MERGE_EVERY)
+    {
+        size_t end = min(chunk.size(), pos + MERGE_EVERY);
+        for (uint32_t &state : active)
+        {
+            uint32_t s = state;
+            for (size_t i = pos; i < end && s != CompiledDFA::DEAD; i++)
+                s = table.Next(s, chunk[i]);
+            state = s;
+        }
+
+        // merge paths that converged and drop dead ones
+        vector<uint32_t> merged = active;
+        sort(merged.begin(), merged.end());
+        merged.erase(unique(merged.begin(), merged.end()), merged.end());
+        if (!merged.empty() && merged.back() == CompiledDFA::DEAD)
+            merged.pop_back();
+        vector<uint32_t> remap(active.size());
+        for (size_t i = 0; i < active.size(); i++)
+        {
+            auto found = lower_bound(merged.begin(), merged.end(), active[i]);
+            remap[i] = (found != merged.end() && *found == active[i]) ? found - merged.begin() : CompiledDFA::DEAD;
+        }
+        for (uint32_t &s : slot)
+            s = (s == CompiledDFA::DEAD) ? s : remap[s];
+        active.swap(merged);
+    }
+
+    result.to.resize(starts.size());
+    for (size_t i = 0; i < starts.size(); i++)
+        result.to[i] = (slot[i] == CompiledDFA::DEAD) ? CompiledDFA::DEAD : active[slot[i]];
+    return result;
+}
+
+uint32_t ParallelMatcher::ChunkMap::Lookup(uint32_t state) const
+{
+    auto found = lower_bound(from.begin(), from.end(), state);
+    if (found == from.end() || *found != state)
+        return CompiledDFA::DEAD;
+    return to[found - from.begin()];
+}
+
+//---------------------------------------------------------------------------------
+// speculative maps for every chunk, computed on the pool
+//---------------------------------------------------------------------------------
+vector<ParallelMatcher::ChunkMap> ParallelMatcher::RunChunks(string_view text, size_t chunkSize) const
+{
+    size_t numChunks = (text.size() + chunkSize - 1) / chunkSize;
+    vector<ChunkMap> maps(numChunks);
+    pool.ParallelFor(numChunks, [&](size_t k) {
+        size_t begin = k * chunkSize;
+        vector<uint32_t> starts = (k == 0) ? vector<uint32_t>{table.Start()}
+                                           : Candidates(text[begin - 1]);
+        maps[k] = RunChunk(text.substr(begin, chunkSize), starts);
+    });
+    return maps;
+}
+
+uint32_t ParallelMatcher::FinalState(string_view text) const
+{
+    uint32_t state = table.Start();
+    if (text.size() < 2 * minChunk)
+    {
+        for (size_t i = 0; i < text.size() && state != CompiledDFA::DEAD; i++)
+            state = table.Next(state, text[i]);
+        return state;
+    }
+
+    vector<ChunkMap> maps = RunChunks(text, ChunkSizeFor(text.size()));
+    for (size_t k = 0; k < maps.size() && state != CompiledDFA::DEAD; k++)
+        state = maps[k].Lookup(state);
+    return state;
+}
+
+bool ParallelMatcher::matches(string_view text) const
+{
+    uint32_t state = FinalState(text);
+    return state != CompiledDFA::DEAD && table.IsAccepting(state);
+}
+
+//---------------------------------------------------------------------------------
+// a scan from begin that records its matches beginning before end. it reads on
+// past end, a piece at a time, while an attempt that began before end is still
+// running
+//---------------------------------------------------------------------------------
+ParallelMatcher::SpeculativeScan ParallelMatcher::ScanFrom(string_view text, size_t begin, size_t end,
+                                                           size_t maxMatch) const
+{
+    SpeculativeScan scan{end, {}, 0};
+    StreamMatcher matcher(table, [&](size_t b, size_t e) {
+        if (begin + b < end)
+            scan.matches.push_back({begin + b, begin + e});
+    }, maxMatch);
+
+    size_t pos = begin;
+    while (begin + matcher.PendingStart() < end && pos < text.size())
+    {
+        string_view piece = text.substr(pos, minChunk);
+        matcher.Feed(piece);
+        pos += piece.size();
+    }
+    if (begin + matcher.PendingStart() < end)
+        matcher.Finish();
+
+    // attempts before end that found nothing step on one byte at a time, so
+    // the scan goes on at end unless the last match reaches past it
+    scan.exit = end;
+    if (!scan.matches.empty())
+    {
+        const MatchSpan &last = scan.matches.back();
+        scan.exit = max(end, last.end > last.begin ? last.end : last.begin + 1);
+    }
+    return scan;
+}
+
+//---------------------------------------------------------------------------------
+// report the matches of one speculative scan that the real scan, now at
+// resume, also finds. a match from an earlier chunk can end inside one of
+// this scan's matches; until the real scan reaches an offset the speculative
+// one tried too, it is run again from resume, once and forward, so the
+// rescan is linear like any other scan
+//---------------------------------------------------------------------------------
+size_t ParallelMatcher::Stitch(string_view text, const SpeculativeScan &scan, size_t &resume,
+                               const function<void(size_t, size_t)> &callback, size_t maxMatch) const
+{
+    auto byBegin = [](const MatchSpan &m, size_t pos) { return m.begin < pos; };
+    // end of the speculative match pos is strictly inside, 0 if there is none
+    auto Inside = [&](size_t pos) -> size_t {
+        if (pos >= scan.end)
+            return 0;
+        auto after = lower_bound(scan.matches.begin(), scan.matches.end(), pos, byBegin);
+        if (after == scan.matches.begin() || prev(after)->end <= pos)
+            return 0;
+        return prev(after)->end;
+    };
+
+    size_t count = 0;
+    size_t until = Inside(resume);
+    if (until)
+    {
+        // a match beginning at until or later is the speculative scan's again
+        size_t from = resume;
+        StreamMatcher matcher(table, [&](size_t b, size_t e) {
+            if (!until)
+                return;
+            if (from + b >= until)
+            {
+                resume = until;
+                until = 0;
+                return;
+            }
+            callback(from + b, from + e);
+            count++;
+            resume = e > b ? from + e : from + b + 1;
+            until = Inside(resume);
+        }, maxMatch);
+        for (size_t pos = from; until;)
+        {
+            if (pos >= text.size())
+            {
+                matcher.Finish();
+                break;
+            }
+            string_view piece = text.substr(pos, minChunk);
+            matcher.Feed(piece);
+            pos += piece.size();
+            if (until && from + matcher.PendingStart() >= until)
+                break;
+        }
+        if (until)
+            resume = until; // no match begins before until
+    }
+    if (resume >= scan.end)
+        return count;
+
+    auto first = lower_bound(scan.matches.begin(), scan.matches.end(), resume, byBegin);
+    for (auto m = first; m != scan.matches.end(); ++m)
+        callback(m->begin, m->end);
+    count += scan.matches.end() - first;
+    resume = scan.exit;
+    return count;
+}
+
+//---------------------------------------------------------------------------------
+// speculative scans for a window of chunks run on the pool, then are stitched
+// in order. a match can begin at every offset up to and including text.size()
+//---------------------------------------------------------------------------------
+size_t ParallelMatcher::find_all(string_view text, const function<void(size_t, size_t)> &callback,
+                                 size_t maxMatch) const
+{
+    size_t offsets = text.size() + 1;
+    size_t numChunks = (offsets + minChunk - 1) / minChunk;
+    if (numChunks < 2 || pool.Size() < 2)
+    {
+        StreamMatcher matcher(table, callback, maxMatch);
+        matcher.Feed(text);
+        matcher.Finish();
+        return matcher.Matches();
+    }
+
+    size_t window = pool.Size() * 4;
+    size_t resume = 0;
+    size_t count = 0;
+    for (size_t first = 0; first < numChunks; first += window)
+    {
+        vector<SpeculativeScan> scans(min(window, numChunks - first));
+        pool.ParallelFor(scans.size(), [&](size_t i) {
+            size_t begin = (first + i) * minChunk;
+            scans[i] = ScanFrom(text, begin, min(begin + minChunk, offsets), maxMatch);
+        });
+        for (const SpeculativeScan &scan : scans)
+            count += Stitch(text, scan, resume, callback, maxMatch);
+    }
+    return count;
+}
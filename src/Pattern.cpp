@@ -0,0 +1,117 @@
+#include "../include/Pattern.h"
+#include "converter.hpp"
+
+//---------------------------------------------------------------------------------
+// Pattern ctor: run the pipeline as far as the selected engine needs. a full
+// DFA that trips options.limits is abandoned for the lazy engine, whose
+// memory is bounded by its cache, unless options.lazyFallback is off.
+// AUTO tries a full DFA of at most options.autoMaxStates states and, when
+// that is not enough, simulates the regex bit-parallel if it has few enough
+// symbols, or lazily if not
+//---------------------------------------------------------------------------------
+Pattern::Pattern(const string &infix, const PatternOptions &options)
+    : source(infix), engine(options.engine)
+{
+    string postfix = InfixToPostfix(infix);
+    RegexDAG dag = RegexDAG::FromPostfix(postfix);
+    Prefilter prefilter = Prefilter::FromDAG(dag);
+    bool fitsBitParallel = GlushkovNFA::CountPositions(postfix) <= GlushkovNFA::MAX_POSITIONS;
+    if (engine == MatchEngine::BIT_PARALLEL)
+    {
+        glushkov = make_unique<GlushkovNFA>(postfix);
+        glushkov->setPrefilter(prefilter);
+        return;
+    }
+
+    NFA thompson = DAGToNFA(dag);
+    NFA nfa = RemoveEpsilons(thompson, nullptr, EpsilonEdgeBudget(thompson));
+    if (engine == MatchEngine::AUTO)
+    {
+        CompileLimits trial = options.limits;
+        if (!trial.max_states || trial.max_states > options.autoMaxStates)
+            trial.max_states = options.autoMaxStates;
+        try
+        {
+            dfa = NFAtoDFA(nfa, nullptr, trial, prefilter);
+            engine = MatchEngine::FULL_DFA;
+        }
+        catch (const DFALimitExceeded &)
+        {
+            engine = fitsBitParallel ? MatchEngine::BIT_PARALLEL : MatchEngine::LAZY_DFA;
+        }
+    }
+    else if (engine == MatchEngine::FULL_DFA)
+    {
+        try
+        {
+            dfa = NFAtoDFA(nfa, nullptr, options.limits, prefilter);
+        }
+        catch (const DFALimitExceeded &)
+        {
+            if (!options.lazyFallback)
+                throw;
+            engine = MatchEngine::LAZY_DFA;
+        }
+    }
+
+    if (engine == MatchEngine::BIT_PARALLEL)
+    {
+        glushkov = make_unique<GlushkovNFA>(postfix);
+        glushkov->setPrefilter(prefilter);
+        return;
+    }
+    if (engine == MatchEngine::LAZY_DFA)
+    {
+        lazy = make_unique<LazyDFA>(nfa, options.lazy);
+        lazy->setPrefilter(prefilter);
+        return;
+    }
+    if (options.minimize)
+        dfa = MinimizeDFA(dfa);
+    table = dfa.Share();
+}
+
+bool Pattern::matches(string_view text) const
+{
+    if (table)
+        return table->matches(text);
+    if (glushkov)
+        return glushkov->matches(text);
+    lock_guard<mutex> guard(lazyLock);
+    return lazy->matches(text);
+}
+
+bool Pattern::search(string_view text, MatchSpan &match) const
+{
+    if (table)
+        return table->search(text, match);
+    if (glushkov)
+        return glushkov->search(text, match);
+    lock_guard<mutex> guard(lazyLock);
+    return lazy->search(text, match);
+}
+
+size_t Pattern::find_all(string_view text, const function<void(size_t, size_t)> &callback) const
+{
+    if (table)
+        return table->find_all(text, callback);
+    if (glushkov)
+        return glushkov->find_all(text, callback);
+    lock_guard<mutex> guard(lazyLock);
+    return lazy->find_all(text, callback);
+}
+
+//---------------------------------------------------------------------------------
+// approximate footprint: the flat table, the map form kept for export (one
+// tree node per transition) or the lazy engine at full capacity
+//---------------------------------------------------------------------------------
+size_t Pattern::MemoryBytes() const
+{
+    const size_t mapNodeBytes = 48;
+    size_t bytes = sizeof(*this) + source.capacity();
+    if (lazy)
+        return bytes + lazy->MemoryBytes();
+    if (glushkov)
+        return bytes + glushkov->MemoryBytes();
+    return bytes + table->MemoryBytes() + mapNodeBytes * (dfa.NumTransitions() + table->NumStates());
+}
@@ -0,0 +1,383 @@
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <memory>
+#include "../include/Prefilter.h"
+#include "../include/RegexDAG.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PREFILTER_X86 1
+#endif
+
+//---------------------------------------------------------------------------------
+// postfix analysis. for every subexpression track whether it matches the
+// empty string, its possible first bytes, a literal all of its matches start
+// with, and whether that literal is the only string it matches
+//---------------------------------------------------------------------------------
+struct PrefixInfo
+{
+    bool nullable;
+    array<bool, 256> first;
+    string literal;
+    bool exact;
+};
+
+static const size_t MAX_LITERAL = 64;
+
+static PrefixInfo SymbolInfo(char c)
+{
+    PrefixInfo info{false, {}, string(1, c), true};
+    info.first[(unsigned char)c] = true;
+    return info;
+}
+
+static void StarInfo(PrefixInfo &inner)
+{
+    inner.nullable = true;
+    inner.literal.clear();
+    inner.exact = false;
+}
+
+static void ConcatInfo(PrefixInfo &left, const PrefixInfo &right)
+{
+    if (left.nullable)
+        for (int b = 0; b < 256; b++)
+            left.first[b] = left.first[b] || right.first[b];
+    left.nullable = left.nullable && right.nullable;
+    if (left.exact)
+    {
+        left.literal += right.literal;
+        left.exact = right.exact;
+    }
+    if (left.literal.size() > MAX_LITERAL)
+    {
+        left.literal.resize(MAX_LITERAL);
+        left.exact = false;
+    }
+}
+
+static void UnionInfo(PrefixInfo &left, const PrefixInfo &right)
+{
+    for (int b = 0; b < 256; b++)
+        left.first[b] = left.first[b] || right.first[b];
+    left.nullable = left.nullable || right.nullable;
+    size_t common = 0;
+    while (common < left.literal.size() && common < right.literal.size() &&
+           left.literal[common] == right.literal[common])
+        common++;
+    left.exact = left.exact && right.exact && left.literal == right.literal;
+    left.literal.resize(common);
+}
+
+static Prefilter FromInfo(const PrefixInfo &whole)
+{
+    if (whole.nullable)
+        return Prefilter(); // every position can start a (possibly empty) match
+    return Prefilter(whole.first, whole.literal);
+}
+
+Prefilter Prefilter::FromPostfix(const string &postfix)
+{
+    vector<PrefixInfo> stack;
+    auto Pop = [&]() {
+        if (stack.empty())
+            throw invalid_argument("malformed regex: operator is missing an operand");
+        PrefixInfo top = move(stack.back());
+        stack.pop_back();
+        return top;
+    };
+
+    for (char c : postfix)
+    {
+        if (isalpha(c))
+        {
+            stack.push_back(SymbolInfo(c));
+        }
+        else if (c == '*')
+        {
+            PrefixInfo inner = Pop();
+            StarInfo(inner);
+            stack.push_back(move(inner));
+        }
+        else if (c == '.' || c == '|')
+        {
+            PrefixInfo right = Pop();
+            PrefixInfo left = Pop();
+            if (c == '.')
+                ConcatInfo(left, right);
+            else
+                UnionInfo(left, right);
+            stack.push_back(move(left));
+        }
+    }
+
+    if (stack.size() != 1)
+        return Prefilter();
+    return FromInfo(stack.back());
+}
+
+//---------------------------------------------------------------------------------
+// bottom-up over the DAG. a node's info is dropped once its last parent has
+// used it, and handed over without a copy to that last parent
+//---------------------------------------------------------------------------------
+Prefilter Prefilter::FromDAG(const RegexDAG &dag)
+{
+    size_t n = dag.NumNodes();
+    vector<size_t> parents(n, 0);
+    for (size_t id = 0; id < n; id++)
+    {
+        const RegexDAGNode &node = dag.Node(id);
+        if (node.left >= 0)
+            parents[node.left]++;
+        if (node.right >= 0)
+            parents[node.right]++;
+    }
+
+    vector<unique_ptr<PrefixInfo>> info(n);
+    auto Take = [&](int child) {
+        if (--parents[child] > 0)
+            return *info[child];
+        PrefixInfo last = move(*info[child]);
+        info[child].reset();
+        return last;
+    };
+
+    for (size_t id = 0; id < n; id++)
+    {
+        const RegexDAGNode &node = dag.Node(id);
+        if (node.left < 0)
+        {
+            info[id] = make_unique<PrefixInfo>(SymbolInfo(node.op));
+            continue;
+        }
+        PrefixInfo left = Take(node.left);
+        if (node.op == '*')
+            StarInfo(left);
+        else
+        {
+            PrefixInfo right = Take(node.right);
+            if (node.op == '.')
+                ConcatInfo(left, right);
+            else
+                UnionInfo(left, right);
+        }
+        info[id] = make_unique<PrefixInfo>(move(left));
+    }
+    return FromInfo(*info[dag.Root()]);
+}
+
+Prefilter::Prefilter(const array<bool, 256> &firstBytes, const string &requiredLiteral)
+    : enabled(true), first(firstBytes), numFirstBytes(0), bytes{}
+{
+    for (int b = 0; b < 256; b++)
+    {
+        if (!first[b])
+            continue;
+        if (numFirstBytes < bytes.size())
+            bytes[numFirstBytes] = b;
+        numFirstBytes++;
+    }
+    if (requiredLiteral.size() >= 2)
+        literal = requiredLiteral;
+}
+
+//---------------------------------------------------------------------------------
+// scan kernels. FindBytes returns the index of the first byte of p[0..n) that
+// is one of bytes[0..count), FindLiteral the index of the first occurrence of
+// needle (2+ bytes). both return n if there is none
+//---------------------------------------------------------------------------------
+static size_t FindBytesScalar(const char *p, size_t n, const uint8_t *bytes, size_t count)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        uint8_t c = p[i];
+        for (size_t k = 0; k < count; k++)
+            if (c == bytes[k])
+                return i;
+    }
+    return n;
+}
+
+static size_t FindLiteralScalar(const char *p, size_t n, const string &needle)
+{
+    size_t k = needle.size();
+    for (size_t i = 0; i + k <= n; i++)
+        if (p[i] == needle[0] && memcmp(p + i + 1, needle.data() + 1, k - 1) == 0)
+            return i;
+    return n;
+}
+
+#ifdef PREFILTER_X86
+// SSE2 is only the x86-64 baseline, so the SSE2 kernels are compiled for it
+// explicitly and picked only when the CPU has it
+__attribute__((target("sse2")))
+static size_t FindBytesSSE2(const char *p, size_t n, const uint8_t *bytes, size_t count)
+{
+    __m128i b0 = _mm_set1_epi8(bytes[0]);
+    __m128i b1 = _mm_set1_epi8(bytes[count > 1 ? 1 : 0]);
+    __m128i b2 = _mm_set1_epi8(bytes[count > 2 ? 2 : 0]);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(block, b0),
+                                  _mm_or_si128(_mm_cmpeq_epi8(block, b1), _mm_cmpeq_epi8(block, b2)));
+        int mask = _mm_movemask_epi8(eq);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + FindBytesScalar(p + i, n - i, bytes, count);
+}
+
+// compare the first and last byte of the needle at 16 offsets at once, then
+// verify the candidates
+__attribute__((target("sse2")))
+static size_t FindLiteralSSE2(const char *p, size_t n, const string &needle)
+{
+    size_t k = needle.size();
+    __m128i firstByte = _mm_set1_epi8(needle[0]);
+    __m128i lastByte = _mm_set1_epi8(needle[k - 1]);
+    size_t i = 0;
+    for (; i + k - 1 + 16 <= n; i += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + k - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, firstByte),
+                                                        _mm_cmpeq_epi8(blockLast, lastByte)));
+        while (mask)
+        {
+            size_t j = __builtin_ctz(mask);
+            if (memcmp(p + i + j + 1, needle.data() + 1, k - 2) == 0)
+                return i + j;
+            mask &= mask - 1;
+        }
+    }
+    return i + FindLiteralScalar(p + i, n - i, needle);
+}
+
+__attribute__((target("avx2")))
+static size_t FindBytesAVX2(const char *p, size_t n, const uint8_t *bytes, size_t count)
+{
+    __m256i b0 = _mm256_set1_epi8(bytes[0]);
+    __m256i b1 = _mm256_set1_epi8(bytes[count > 1 ? 1 : 0]);
+    __m256i b2 = _mm256_set1_epi8(bytes[count > 2 ? 2 : 0]);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(block, b0),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(block, b1), _mm256_cmpeq_epi8(block, b2)));
+        unsigned mask = _mm256_movemask_epi8(eq);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + FindBytesSSE2(p + i, n - i, bytes, count);
+}
+
+__attribute__((target("avx2")))
+static size_t FindLiteralAVX2(const char *p, size_t n, const string &needle)
+{
+    size_t k = needle.size();
+    __m256i firstByte = _mm256_set1_epi8(needle[0]);
+    __m256i lastByte = _mm256_set1_epi8(needle[k - 1]);
+    size_t i = 0;
+    for (; i + k - 1 + 32 <= n; i += 32)
+    {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + k - 1));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, firstByte),
+                                                               _mm256_cmpeq_epi8(blockLast, lastByte)));
+        while (mask)
+        {
+            size_t j = __builtin_ctz(mask);
+            if (memcmp(p + i + j + 1, needle.data() + 1, k - 2) == 0)
+                return i + j;
+            mask &= mask - 1;
+        }
+    }
+    return i + FindLiteralSSE2(p + i, n - i, needle);
+}
+#endif
+
+//---------------------------------------------------------------------------------
+// runtime CPU dispatch, resolved once: the best kernel this CPU runs, scalar
+// when it has no SSE2
+//---------------------------------------------------------------------------------
+struct ScanKernels
+{
+    const char *name;
+    size_t (*findBytes)(const char *, size_t, const uint8_t *, size_t);
+    size_t (*findLiteral)(const char *, size_t, const string &);
+};
+
+// best first
+static vector<ScanKernels> CPUKernels()
+{
+    vector<ScanKernels> kernels;
+#ifdef PREFILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back({"avx2", FindBytesAVX2, FindLiteralAVX2});
+    if (__builtin_cpu_supports("sse2"))
+        kernels.push_back({"sse2", FindBytesSSE2, FindLiteralSSE2});
+#endif
+    kernels.push_back({"scalar", FindBytesScalar, FindLiteralScalar});
+    return kernels;
+}
+
+static ScanKernels &ActiveKernels()
+{
+    static ScanKernels kernels = CPUKernels().front();
+    return kernels;
+}
+
+const char *Prefilter::Kernel()
+{
+    return ActiveKernels().name;
+}
+
+vector<string> Prefilter::Kernels()
+{
+    vector<string> names;
+    for (const ScanKernels &kernels : CPUKernels())
+        names.push_back(kernels.name);
+    return names;
+}
+
+bool Prefilter::UseKernel(const string &name)
+{
+    for (const ScanKernels &kernels : CPUKernels())
+    {
+        if (name == kernels.name)
+        {
+            ActiveKernels() = kernels;
+            return true;
+        }
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------
+// skip to the next position where a match could start
+//---------------------------------------------------------------------------------
+size_t Prefilter::NextCandidate(string_view text, size_t pos) const
+{
+    if (!enabled || pos > text.size())
+        return pos;
+
+    const char *p = text.data() + pos;
+    size_t n = text.size() - pos;
+    size_t found;
+    if (!literal.empty())
+        found = ActiveKernels().findLiteral(p, n, literal);
+    else if (numFirstBytes <= bytes.size())
+        found = ActiveKernels().findBytes(p, n, bytes.data(), numFirstBytes);
+    else
+    {
+        found = 0;
+        while (found < n && !first[(unsigned char)p[found]])
+            found++;
+    }
+    return found == n ? string_view::npos : pos + found;
+}
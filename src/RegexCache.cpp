@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cctype>
+#include "../include/RegexCache.h"
+
+//---------------------------------------------------------------------------------
+// RegexCache ctor
+//---------------------------------------------------------------------------------
+RegexCache::RegexCache(size_t budgetBytes, const PatternOptions &opts) : options(opts), budget(budgetBytes)
+{
+}
+
+RegexCache &RegexCache::Global()
+{
+    static RegexCache cache;
+    return cache;
+}
+
+string RegexCache::Normalize(const string &infix)
+{
+    string key = infix;
+    key.erase(remove_if(key.begin(), key.end(), [](unsigned char c) { return isspace(c); }), key.end());
+    return key;
+}
+
+//---------------------------------------------------------------------------------
+// the compiled pattern for infix. compiles outside the lock, at most once
+// per key at a time
+//---------------------------------------------------------------------------------
+shared_ptr<const Pattern> RegexCache::Get(const string &infix)
+{
+    string key = Normalize(infix);
+
+    promise<shared_ptr<const Pattern>> result;
+    {
+        unique_lock<mutex> guard(lock);
+        auto found = entries.find(key);
+        if (found != entries.end())
+        {
+            stats.hits++;
+            lru.splice(lru.begin(), lru, found->second.recent);
+            return found->second.pattern;
+        }
+        auto pending = compiling.find(key);
+        if (pending != compiling.end())
+        {
+            stats.coalesced++;
+            shared_future<shared_ptr<const Pattern>> waitFor = pending->second;
+            guard.unlock();
+            return waitFor.get();
+        }
+        stats.misses++;
+        compiling.emplace(key, result.get_future().share());
+    }
+
+    shared_ptr<const Pattern> pattern;
+    try
+    {
+        pattern = make_shared<const Pattern>(key, options);
+    }
+    catch (...)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            compiling.erase(key);
+        }
+        result.set_exception(current_exception());
+        throw;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        compiling.erase(key);
+        size_t bytes = pattern->MemoryBytes() + key.capacity();
+        lru.push_front(key);
+        entries.emplace(key, Entry{pattern, bytes, lru.begin()});
+        stats.bytes += bytes;
+        EvictOverBudget();
+    }
+    result.set_value(pattern);
+    return pattern;
+}
+
+//---------------------------------------------------------------------------------
+// drop least recently used entries until the cache fits the budget. callers
+// keep their shared_ptr, so evicted patterns stay alive while in use
+//---------------------------------------------------------------------------------
+void RegexCache::EvictOverBudget()
+{
+    while (stats.bytes > budget && !lru.empty())
+    {
+        auto victim = entries.find(lru.back());
+        stats.bytes -= victim->second.bytes;
+        entries.erase(victim);
+        lru.pop_back();
+        stats.evictions++;
+    }
+}
+
+void RegexCache::SetBudget(size_t budgetBytes)
+{
+    lock_guard<mutex> guard(lock);
+    budget = budgetBytes;
+    EvictOverBudget();
+}
+
+size_t RegexCache::Budget() const
+{
+    lock_guard<mutex> guard(lock);
+    return budget;
+}
+
+RegexCacheStats RegexCache::Stats() const
+{
+    lock_guard<mutex> guard(lock);
+    RegexCacheStats snapshot = stats;
+    snapshot.entries = entries.size();
+    return snapshot;
+}
+
+void RegexCache::Clear()
+{
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    lru.clear();
+    stats.bytes = 0;
+}
@@ -0,0 +1,101 @@
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include "../include/RegexDAG.h"
+
+static size_t SaturatingAdd(size_t a, size_t b)
+{
+    return a > SIZE_MAX - b ? SIZE_MAX : a + b;
+}
+
+//---------------------------------------------------------------------------------
+// one pass over the postfix with a stack of node ids. every new node is
+// looked up by (op, left, right) first, so a repeated subexpression finds the
+// node its first occurrence created
+//---------------------------------------------------------------------------------
+RegexDAG RegexDAG::FromPostfix(const string &postfix)
+{
+    RegexDAG dag;
+    unordered_map<uint64_t, int> ids; // (op, left + 1, right + 1) packed
+    auto Intern = [&](char op, int left, int right) {
+        uint64_t key = uint64_t((unsigned char)op) << 56 | uint64_t(left + 1) << 28 | uint64_t(right + 1);
+        auto found = ids.find(key);
+        if (found != ids.end())
+            return found->second;
+        int id = dag.nodes.size();
+        dag.nodes.push_back({op, left, right});
+        size_t size = 1;
+        if (left >= 0)
+            size = SaturatingAdd(size, dag.treeSize[left]);
+        if (right >= 0)
+            size = SaturatingAdd(size, dag.treeSize[right]);
+        dag.treeSize.push_back(size);
+        ids.emplace(key, id);
+        return id;
+    };
+    if (postfix.size() >= (size_t(1) << 27))
+        throw invalid_argument("regex too long for the expression DAG");
+    ids.reserve(postfix.size());
+
+    vector<int> stack;
+    auto Pop = [&]() {
+        if (stack.empty())
+            throw invalid_argument("malformed regex: operator is missing an operand");
+        int top = stack.back();
+        stack.pop_back();
+        return top;
+    };
+
+    for (char c : postfix)
+    {
+        if (isalpha(c))
+        {
+            stack.push_back(Intern(c, -1, -1));
+        }
+        else if (c == '*')
+        {
+            int inner = Pop();
+            stack.push_back(Intern(c, inner, -1));
+        }
+        else if (c == '.' || c == '|')
+        {
+            int right = Pop();
+            int left = Pop();
+            stack.push_back(Intern(c, left, right));
+        }
+    }
+    if (stack.size() != 1)
+        throw invalid_argument(stack.empty() ? "malformed regex: no operands"
+                                             : "malformed regex: operands without an operator");
+    dag.root = stack.back();
+
+    // parents before children: descending ids
+    dag.occurrences.assign(dag.nodes.size(), 0);
+    dag.occurrences[dag.root] = 1;
+    for (int id = dag.root; id >= 0; id--)
+    {
+        const RegexDAGNode &node = dag.nodes[id];
+        if (node.left >= 0)
+            dag.occurrences[node.left] = SaturatingAdd(dag.occurrences[node.left], dag.occurrences[id]);
+        if (node.right >= 0)
+            dag.occurrences[node.right] = SaturatingAdd(dag.occurrences[node.right], dag.occurrences[id]);
+    }
+    return dag;
+}
+
+RegexDAGStats RegexDAG::Stats() const
+{
+    RegexDAGStats stats;
+    stats.treeNodes = treeSize[root];
+    stats.dagNodes = nodes.size();
+    for (size_t id = 0; id < nodes.size(); id++)
+    {
+        if (occurrences[id] > 1 && nodes[id].left >= 0)
+        {
+            stats.sharedNodes++;
+            stats.largestShared = max(stats.largestShared, treeSize[id]);
+        }
+    }
+    return stats;
+}
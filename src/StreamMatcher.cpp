@@ -0,0 +1,217 @@
+#include <algorithm>
+#include "../include/StreamMatcher.h"
+
+//---------------------------------------------------------------------------------
+// StreamMatcher ctor
+//---------------------------------------------------------------------------------
+StreamMatcher::StreamMatcher(const CompiledDFA &dfa, const function<void(size_t, size_t)> &callback,
+                             size_t maxMatchBytes)
+    : table(dfa), onMatch(callback), maxMatch(max<size_t>(maxMatchBytes, 1))
+{
+    Reset();
+}
+
+void StreamMatcher::Reset()
+{
+    streamPos = 0;
+    carry.clear();
+    carryStart = 0;
+    matches = 0;
+    truncated = 0;
+    memo.assign(64, 0);
+    memoBase = 0;
+    memoTop = 0;
+    memoEnd = 0;
+    memoAccept = NO_MATCH;
+    memoCut = false;
+    StartAttempt(0);
+}
+
+//---------------------------------------------------------------------------------
+// begin an anchored match attempt at stream offset pos. the memo keeps only
+// the states after pos, where this attempt can meet the last one
+//---------------------------------------------------------------------------------
+void StreamMatcher::StartAttempt(size_t pos)
+{
+    attemptStart = pos;
+    scanned = pos;
+    state = table.Start();
+    lastAccept = table.IsAccepting(state) ? pos : NO_MATCH;
+    cut = false;
+    memoBase = max(memoBase, pos + 1);
+    memoTop = max(memoTop, memoBase);
+}
+
+//---------------------------------------------------------------------------------
+// double the memo ring, up to what an attempt of maxMatch bytes needs
+//---------------------------------------------------------------------------------
+void StreamMatcher::GrowMemo()
+{
+    vector<uint32_t> grown(memo.size() * 2);
+    for (size_t pos = memoBase; pos < memoTop; pos++)
+        grown[pos & (grown.size() - 1)] = memo[pos & (memo.size() - 1)];
+    memo.swap(grown);
+}
+
+//---------------------------------------------------------------------------------
+// advance the attempt over data, which holds stream bytes [base, end).
+// returns true if the attempt is over: the DFA died at scanned, it met the
+// last attempt and ends where that one did, or it was cut off at maxMatch
+//---------------------------------------------------------------------------------
+bool StreamMatcher::Step(const char *data, size_t base, size_t end)
+{
+    size_t limit = end - attemptStart > maxMatch ? attemptStart + maxMatch : end;
+    uint32_t s = state;
+    while (scanned < limit)
+    {
+        size_t mask = memo.size() - 1;
+
+        // offsets the last attempt reached: meeting its state there ends this one
+        size_t shared = min({limit, memoEnd, memoTop - 1});
+        for (; scanned < shared; scanned++)
+        {
+            s = table.Next(s, data[scanned - base]);
+            if (s == CompiledDFA::DEAD)
+                return true;
+            size_t pos = scanned + 1;
+            if (table.IsAccepting(s))
+                lastAccept = pos;
+            if (memo[pos & mask] == s)
+            {
+                if (memoAccept != NO_MATCH && memoAccept > pos)
+                    lastAccept = memoAccept;
+                cut = memoCut;
+                scanned = memoEnd;
+                return true;
+            }
+            memo[pos & mask] = s;
+        }
+
+        // past them, only record the states for the next attempt
+        size_t room = min(limit, memoBase + mask);
+        bool dead = false;
+        for (; scanned < room; scanned++)
+        {
+            s = table.Next(s, data[scanned - base]);
+            if (s == CompiledDFA::DEAD)
+            {
+                dead = true;
+                break;
+            }
+            if (table.IsAccepting(s))
+                lastAccept = scanned + 1;
+            memo[(scanned + 1) & mask] = s;
+        }
+        memoTop = max(memoTop, scanned + 1);
+        if (dead)
+            return true;
+        if (scanned < limit)
+            GrowMemo();
+    }
+    state = s;
+    cut = scanned - attemptStart == maxMatch;
+    return cut;
+}
+
+//---------------------------------------------------------------------------------
+// the attempt is over: report its longest match and start the next attempt
+// where find_all would
+//---------------------------------------------------------------------------------
+void StreamMatcher::Resolve()
+{
+    memoEnd = scanned;
+    memoAccept = lastAccept;
+    memoCut = cut;
+    if (cut)
+        truncated++;
+
+    size_t next = attemptStart + 1;
+    if (lastAccept != NO_MATCH)
+    {
+        onMatch(attemptStart, lastAccept);
+        matches++;
+        if (lastAccept > attemptStart)
+            next = lastAccept;
+    }
+    StartAttempt(next);
+}
+
+//---------------------------------------------------------------------------------
+// move a fresh attempt that begins inside chunk to the next position the
+// prefilter allows. with no candidate left, only the last bytes that could
+// start a literal continuing into the next chunk are still attempted
+//---------------------------------------------------------------------------------
+void StreamMatcher::SkipToCandidate(string_view chunk, size_t chunkBase)
+{
+    const Prefilter &prefilter = table.getPrefilter();
+    if (!prefilter.Enabled())
+        return;
+
+    size_t found = prefilter.NextCandidate(chunk, attemptStart - chunkBase);
+    if (found != NO_MATCH)
+    {
+        StartAttempt(chunkBase + found);
+        return;
+    }
+    size_t tail = min(max<size_t>(prefilter.Literal().size(), 1) - 1, chunk.size());
+    StartAttempt(max(attemptStart, chunkBase + chunk.size() - tail));
+}
+
+//---------------------------------------------------------------------------------
+// scan the next chunk of the stream
+//---------------------------------------------------------------------------------
+void StreamMatcher::Feed(string_view chunk)
+{
+    size_t chunkBase = streamPos;
+    size_t chunkEnd = chunkBase + chunk.size();
+    streamPos = chunkEnd;
+
+    for (;;)
+    {
+        // a restarted attempt may begin in bytes carried over from earlier chunks
+        if (scanned < chunkBase && Step(carry.data(), carryStart, chunkBase))
+        {
+            Resolve();
+            continue;
+        }
+        if (scanned == attemptStart && scanned >= chunkBase)
+            SkipToCandidate(chunk, chunkBase);
+        if (Step(chunk.data(), chunkBase, chunkEnd))
+        {
+            Resolve();
+            continue;
+        }
+        break;
+    }
+
+    // keep only the bytes the next attempt could restart from
+    size_t keepFrom = attemptStart + 1;
+    if (lastAccept != NO_MATCH && lastAccept > keepFrom)
+        keepFrom = lastAccept;
+    keepFrom = min(keepFrom, chunkEnd);
+    if (keepFrom >= chunkBase)
+        carry.assign(chunk.substr(keepFrom - chunkBase));
+    else
+    {
+        carry.erase(0, keepFrom - carryStart);
+        carry.append(chunk);
+    }
+    carryStart = keepFrom;
+}
+
+//---------------------------------------------------------------------------------
+// end of stream: every live attempt ends here
+//---------------------------------------------------------------------------------
+void StreamMatcher::Finish()
+{
+    size_t end = streamPos;
+    while (attemptStart <= end)
+    {
+        if (scanned < end && Step(carry.data(), carryStart, end))
+        {
+            Resolve();
+            continue;
+        }
+        Resolve();
+    }
+}
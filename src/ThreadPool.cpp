@@ -0,0 +1,70 @@
+#include "../include/ThreadPool.h"
+
+//---------------------------------------------------------------------------------
+// start the workers
+//---------------------------------------------------------------------------------
+ThreadPool::ThreadPool(size_t threads) : stopping(false)
+{
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back([this]() { WorkerLoop(); });
+}
+
+//---------------------------------------------------------------------------------
+// finish the queued tasks and join the workers
+//---------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wakeup.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return; // stopping and drained
+            task = move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+//---------------------------------------------------------------------------------
+// one task per index, rethrows the first exception once all have finished
+//---------------------------------------------------------------------------------
+void ThreadPool::ParallelFor(size_t n, const function<void(size_t)> &body)
+{
+    vector<future<void>> pending;
+    pending.reserve(n);
+    for (size_t i = 0; i < n; i++)
+        pending.push_back(Submit([&body, i]() { body(i); }));
+
+    exception_ptr failure;
+    for (future<void> &f : pending)
+    {
+        try
+        {
+            f.get();
+        }
+        catch (...)
+        {
+            if (!failure)
+                failure = current_exception();
+        }
+    }
+    if (failure)
+        rethrow_exception(failure);
+}
@@ -0,0 +1,48 @@
+#include <exception>
+#include <stdexcept>
+#include "batch.hpp"
+
+using namespace std;
+
+vector<BatchResult> compileBatch(const vector<BatchPattern>& patterns, ThreadPool& pool, const CompileOptions& options,
+                                 const function<void(size_t, const CompiledAutomata&, const PipelineStats&)>& output) {
+    vector<BatchResult> results(patterns.size());
+    CompileOptions concurrent = options;
+    concurrent.measurePeak = false;
+    // every task catches its own errors, so ParallelFor never sees one
+    pool.ParallelFor(patterns.size(), [&](size_t i) {
+        try {
+            if (patterns[i].regex.empty()) {
+                throw invalid_argument("empty regex");
+            }
+            CompiledAutomata automata = compileRegex(patterns[i].regex, concurrent, &results[i].stats);
+            output(i, automata, results[i].stats);
+        } catch (const exception& e) {
+            results[i].error = e.what();
+        } catch (...) {
+            results[i].error = "unknown error";
+        }
+    });
+    return results;
+}
+
+json batchReportToJson(const vector<BatchPattern>& patterns, const vector<BatchResult>& results) {
+    json entries = json::array();
+    size_t failed = 0;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        json entry = {{"name", patterns[i].name}, {"regex", patterns[i].regex}};
+        if (!results[i].error.empty()) {
+            entry["error"] = results[i].error;
+            failed++;
+        } else {
+            entry["dfaStates"] = results[i].stats.minDfaStates;
+            entry["ms"] = results[i].stats.totalMs;
+        }
+        entries.push_back(entry);
+    }
+    json report;
+    report["patterns"] = patterns.size();
+    report["failed"] = failed;
+    report["results"] = entries;
+    return report;
+}
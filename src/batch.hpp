@@ -0,0 +1,35 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "../include/ThreadPool.h"
+#include "converter.hpp"
+#include "json_export.hpp"
+
+// one regex of a batch. name identifies it in the report and names its output
+struct BatchPattern
+{
+    std::string name;
+    std::string regex;
+};
+
+struct BatchResult
+{
+    std::string error; // empty if the pattern compiled
+    PipelineStats stats;
+};
+
+// compileRegex every pattern as its own task on the pool. a pattern that
+// throws, here or in output, records the error and the rest of the batch
+// carries on. output(i, automata, stats) runs on the worker that compiled
+// pattern i. the compiles overlap, so stats carry no peakBytes
+std::vector<BatchResult> compileBatch(
+    const std::vector<BatchPattern>& patterns, ThreadPool& pool, const CompileOptions& options,
+    const std::function<void(size_t, const CompiledAutomata&, const PipelineStats&)>& output);
+
+// {"patterns", "failed", "results": [{name, regex, error} or {name, regex, dfaStates, ms}]}
+json batchReportToJson(const std::vector<BatchPattern>& patterns, const std::vector<BatchResult>& results);
+
+#endif
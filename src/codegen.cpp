@@ -0,0 +1,201 @@
+#include <sstream>
+#include <vector>
+#include <map>
+#include <set>
+#include <cctype>
+#include <stdexcept>
+#include "codegen.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------
+// shared preamble: include guard, includes and the namespace
+//---------------------------------------------------------------------
+static void EmitPreamble(ostringstream& out, const string& name, const string& source, CodegenStyle style)
+{
+    string guard = "GENERATED_DFA_";
+    for (char c : name)
+        guard += isalnum((unsigned char)c) ? (char)toupper((unsigned char)c) : '_';
+    guard += "_H";
+
+    out << "// generated by state_machine_visualizer --emit-cpp, do not edit\n";
+    if (!source.empty())
+        out << "// regex: " << source << "\n";
+    out << "// style: " << (style == CodegenStyle::TABLE ? "table" : "switch") << "\n";
+    out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+    out << "#include <cstddef>\n#include <cstdint>\n#include <string_view>\n\n";
+    out << "namespace " << name << "\n{\n\n";
+}
+
+//---------------------------------------------------------------------
+// constexpr arrays and a table-walking loop: the interpreter with the
+// automaton baked in as compile-time constants
+//---------------------------------------------------------------------
+static void EmitTable(ostringstream& out, const CompiledDFA& dfa)
+{
+    size_t n = dfa.NumStates();
+    size_t width = dfa.AlphabetWidth();
+
+    out << "inline constexpr std::uint32_t dead = 0xFFFFFFFFu;\n";
+    out << "inline constexpr std::uint32_t start = " << dfa.Start() << ";\n";
+    out << "inline constexpr std::uint32_t width = " << width << ";\n\n";
+
+    out << "inline constexpr std::uint8_t byte_class[256] = {";
+    for (int b = 0; b < 256; b++)
+        out << (b % 32 == 0 ? "\n    " : "") << (int)dfa.ByteClasses()[b] << ",";
+    out << "\n};\n\n";
+
+    out << "inline constexpr std::uint32_t transitions[" << n * width << "] = {";
+    for (size_t s = 0; s < n; s++)
+    {
+        out << "\n    ";
+        for (size_t cls = 0; cls < width; cls++)
+        {
+            uint32_t dst = dfa.Table()[s * width + cls];
+            if (dst == CompiledDFA::DEAD)
+                out << "dead,";
+            else
+                out << dst << ",";
+        }
+    }
+    out << "\n};\n\n";
+
+    out << "inline constexpr bool accepting[" << n << "] = {";
+    for (size_t s = 0; s < n; s++)
+        out << (s % 32 == 0 ? "\n    " : "") << (dfa.IsAccepting(s) ? "true," : "false,");
+    out << "\n};\n\n";
+
+    out << "constexpr bool match(std::string_view text)\n{\n"
+           "    std::uint32_t state = start;\n"
+           "    for (char c : text)\n"
+           "    {\n"
+           "        state = transitions[state * width + byte_class[(unsigned char)c]];\n"
+           "        if (state == dead)\n"
+           "            return false;\n"
+           "    }\n"
+           "    return accepting[state];\n"
+           "}\n\n";
+
+    out << "constexpr std::size_t longest_match(std::string_view text, std::size_t pos = 0)\n{\n"
+           "    std::uint32_t state = start;\n"
+           "    std::size_t last = accepting[state] ? pos : std::string_view::npos;\n"
+           "    for (std::size_t i = pos; i < text.size(); i++)\n"
+           "    {\n"
+           "        state = transitions[state * width + byte_class[(unsigned char)text[i]]];\n"
+           "        if (state == dead)\n"
+           "            break;\n"
+           "        if (accepting[state])\n"
+           "            last = i + 1;\n"
+           "    }\n"
+           "    return last;\n"
+           "}\n\n";
+}
+
+//---------------------------------------------------------------------
+// the case labels of one state: bytes grouped by target state
+//---------------------------------------------------------------------
+static void EmitCases(ostringstream& out, const CompiledDFA& dfa, uint32_t s, const string& target)
+{
+    map<uint32_t, vector<int>> bytesTo;
+    for (int b = 0; b < 256; b++)
+    {
+        uint32_t dst = dfa.Next(s, b);
+        if (dst != CompiledDFA::DEAD)
+            bytesTo[dst].push_back(b);
+    }
+    for (const auto& group : bytesTo)
+    {
+        out << "        ";
+        for (int b : group.second)
+        {
+            out << "case " << b << ": ";
+        }
+        out << target << group.first << ";\n";
+    }
+}
+
+//---------------------------------------------------------------------
+// direct-coded automaton: every state is a label and every transition a
+// goto, so there is no table left to load from. goto rules out constexpr,
+// the functions are plain inline
+//---------------------------------------------------------------------
+static void EmitSwitch(ostringstream& out, const CompiledDFA& dfa)
+{
+    size_t n = dfa.NumStates();
+
+    out << "inline bool match(std::string_view text)\n{\n"
+           "    const char *p = text.data();\n"
+           "    const char *end = p + text.size();\n"
+           "    goto s" << dfa.Start() << ";\n";
+    for (uint32_t s = 0; s < n; s++)
+    {
+        out << "s" << s << ":\n"
+            << "    if (p == end)\n"
+            << "        return " << (dfa.IsAccepting(s) ? "true" : "false") << ";\n"
+            << "    switch ((unsigned char)*p++)\n    {\n";
+        EmitCases(out, dfa, s, "goto s");
+        out << "        default: return false;\n    }\n";
+    }
+    out << "}\n\n";
+
+    out << "inline std::size_t longest_match(std::string_view text, std::size_t pos = 0)\n{\n"
+           "    const char *begin = text.data();\n"
+           "    const char *p = begin + pos;\n"
+           "    const char *end = begin + text.size();\n"
+           "    std::size_t last = std::string_view::npos;\n"
+           "    goto s" << dfa.Start() << ";\n";
+    for (uint32_t s = 0; s < n; s++)
+    {
+        out << "s" << s << ":\n";
+        if (dfa.IsAccepting(s))
+            out << "    last = std::size_t(p - begin);\n";
+        out << "    if (p == end)\n"
+            << "        return last;\n"
+            << "    switch ((unsigned char)*p++)\n    {\n";
+        EmitCases(out, dfa, s, "goto s");
+        out << "        default: return last;\n    }\n";
+    }
+    out << "}\n\n";
+}
+
+//---------------------------------------------------------------------
+// can name be a namespace: letters, digits and '_', not starting with a
+// digit, and not a keyword
+//---------------------------------------------------------------------
+static bool IsIdentifier(const string& name)
+{
+    static const set<string> keywords = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case",
+        "catch", "char", "char16_t", "char32_t", "class", "compl", "const", "const_cast", "constexpr",
+        "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+        "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int",
+        "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+        "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "return", "short",
+        "signed", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template",
+        "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union",
+        "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq"};
+    if (name.empty() || isdigit((unsigned char)name[0]) || keywords.count(name))
+        return false;
+    for (char c : name)
+        if (!isalnum((unsigned char)c) && c != '_')
+            return false;
+    return true;
+}
+
+//---------------------------------------------------------------------
+// generate a self-contained header for dfa in namespace name. throws
+// invalid_argument if name is not a C++ identifier
+//---------------------------------------------------------------------
+string GenerateDFAHeader(const CompiledDFA& dfa, const string& name, CodegenStyle style, const string& source)
+{
+    if (!IsIdentifier(name))
+        throw invalid_argument("namespace name is not a C++ identifier: " + name);
+    ostringstream out;
+    EmitPreamble(out, name, source, style);
+    if (style == CodegenStyle::TABLE)
+        EmitTable(out, dfa);
+    else
+        EmitSwitch(out, dfa);
+    out << "} // namespace " << name << "\n\n#endif\n";
+    return out.str();
+}
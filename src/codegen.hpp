@@ -0,0 +1,19 @@
+#ifndef CODEGEN_HPP
+#define CODEGEN_HPP
+
+#include <string>
+#include "../include/CompiledDFA.h"
+
+// TABLE: constexpr byte class map and transition array walked by a loop.
+// SWITCH: one label per state, a switch on the next byte jumps between them
+enum class CodegenStyle {TABLE, SWITCH};
+
+// self-contained C++17 header defining, in namespace name:
+//   bool match(std::string_view text)                  whole text matches
+//   std::size_t longest_match(std::string_view, pos)   end of the longest match at pos, or npos
+// both are constexpr in the TABLE style. throws invalid_argument if name is
+// not a C++ identifier
+std::string GenerateDFAHeader(const CompiledDFA& dfa, const std::string& name, CodegenStyle style,
+                              const std::string& source = "");
+
+#endif
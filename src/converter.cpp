@@ -3,10 +3,26 @@
 #include <queue>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <cctype>
+#include <stdexcept>
+#include <chrono>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <optional>
+#include "../include/AllocTracker.h"
 
 using namespace std;
 
+static double MillisecondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
 //---------------------------------------------------------------------
 // define precedence and associativity of operators
 //---------------------------------------------------------------------
@@ -30,7 +46,8 @@ bool IsOperand(char c)
 }
 
 //---------------------------------------------------------------------
-// convert an infix regular expression to postfix
+// convert an infix regular expression to postfix, throws invalid_argument
+// on unbalanced parentheses
 //---------------------------------------------------------------------
 string InfixToPostfix(const string& infix)
 {
@@ -57,6 +74,8 @@ string InfixToPostfix(const string& infix)
                 postfix += ops.top();
                 ops.pop();
             }
+            if (ops.empty())
+                throw invalid_argument("malformed regex: unmatched ')' at position " + to_string(i));
             ops.pop(); // pop the '('
         }
         else if (c == '|')
@@ -88,6 +107,8 @@ string InfixToPostfix(const string& infix)
     // pop all remaining operators off the stack
     while (!ops.empty())
     {
+        if (ops.top() == '(')
+            throw invalid_argument("malformed regex: unmatched '('");
         postfix += ops.top();
         ops.pop();
     }
@@ -95,204 +116,1107 @@ string InfixToPostfix(const string& infix)
 }
 
 //---------------------------------------------------------------------
-// convert a regular expression in postfix to an NFA using Thompson's construction
+// Thompson's construction of a postfix regex into an existing builder.
+// every fragment lives in one arena, so operators only append states and edges
+// and the whole construction is linear in the length of the postfix
 //---------------------------------------------------------------------
-NFA PostfixToNFA(const string& postfix)
+NFAFragment PostfixToFragment(NFABuilder& builder, const string& postfix)
 {
-    stack<NFA> nfa_stack;
-    int stateCount = 0;
+    vector<NFAFragment> nfa_stack;
+    auto Pop = [&]() {
+        if (nfa_stack.empty())
+            throw invalid_argument("malformed regex: operator is missing an operand");
+        NFAFragment top = move(nfa_stack.back());
+        nfa_stack.pop_back();
+        return top;
+    };
+
     for (size_t i = 0; i < postfix.size(); i++)
     {
         char c = postfix[i];
         // Creates a transition on the input character to a final state
         if (IsOperand(c)) 
         {
-            int start = stateCount++;
-            int end = stateCount++;
-            NFA myNFA({c}, start, {end});
-            myNFA.AddTransition(start, {end}, c);
-
-            nfa_stack.push(myNFA);
+            nfa_stack.push_back(builder.Symbol(c));
         }
         else if (c == '*')
         {
-            NFA myNFA = nfa_stack.top();
-            nfa_stack.pop();
-        
-            // Create new states
-            int newStart = stateCount++;
-            int newFinal = stateCount++;
-        
-            // Create a new NFA with the same alphabet
-            NFA newNFA(myNFA.getAlpha(), newStart, {newFinal});
-        
-            // From new start state, add ε-transitions to:
-            // 1. myNFA's initial state 
-            // 2. New final state 
-            newNFA.AddTransition(newStart, {myNFA.getInitState(), newFinal}, '_');
-        
-            // Merge the NFA into the new NFA
-            newNFA.Merge(myNFA);
-        
-            // From myNFA's final states, add ε-transitions to:
-            // 1. myNFA's initial state 
-            // 2. New final state 
-            for (int finalState : myNFA.getFinalStates())
+            NFAFragment inner = Pop();
+            nfa_stack.push_back(builder.Star(move(inner)));
+        }
+        else if (c == '.')
+        {
+            NFAFragment nfa2 = Pop();
+            NFAFragment nfa1 = Pop();
+            nfa_stack.push_back(builder.Concat(move(nfa1), move(nfa2)));
+        }
+        else if (c == '|')
+        {
+            NFAFragment nfa2 = Pop();
+            NFAFragment nfa1 = Pop();
+            nfa_stack.push_back(builder.Union(move(nfa1), move(nfa2)));
+        }
+    }
+    if (nfa_stack.size() != 1)
+        throw invalid_argument(nfa_stack.empty() ? "malformed regex: no operands"
+                                                 : "malformed regex: operands without an operator");
+    return move(nfa_stack.back());
+}
+
+//---------------------------------------------------------------------
+// Thompson's construction over a hash-consed expression DAG, walked
+// depth-first with an explicit stack. the first occurrence of a repeated
+// operator is built normally and its state and edge ranges kept as a
+// template; later occurrences are copied from it without walking the subtree
+//---------------------------------------------------------------------
+NFAFragment DAGToFragment(NFABuilder& builder, const RegexDAG& dag, PipelineStats* stats)
+{
+    vector<NFATemplate> templates(dag.NumNodes(), NFATemplate{0, -1, 0, 0, 0, 0});
+    struct Frame
+    {
+        int node;
+        bool expanded;
+        int firstState;
+        size_t firstEdge;
+    };
+    vector<Frame> frames = {{dag.Root(), false, 0, 0}};
+    vector<NFAFragment> fragments;
+    auto Pop = [&]() {
+        NFAFragment top = move(fragments.back());
+        fragments.pop_back();
+        return top;
+    };
+
+    while (!frames.empty())
+    {
+        Frame &frame = frames.back();
+        const RegexDAGNode &node = dag.Node(frame.node);
+        if (!frame.expanded)
+        {
+            if (templates[frame.node].numStates >= 0)
+            {
+                if (stats)
+                    stats->clonedStates += templates[frame.node].numStates;
+                fragments.push_back(builder.Clone(templates[frame.node]));
+                frames.pop_back();
+                continue;
+            }
+            if (node.left < 0)
             {
-                newNFA.AddTransition(finalState, {myNFA.getInitState(), newFinal}, '_');
+                fragments.push_back(builder.Symbol(node.op));
+                frames.pop_back();
+                continue;
             }
-        
-            nfa_stack.push(newNFA);
+            frame.expanded = true;
+            frame.firstState = builder.NumStates();
+            frame.firstEdge = builder.NumEdges();
+            int left = node.left, right = node.right;
+            if (right >= 0)
+                frames.push_back({right, false, 0, 0});
+            frames.push_back({left, false, 0, 0}); // left is built first, as in postfix order
+            continue;
         }
-        else if (c == '.')
+
+        if (node.op == '*')
+        {
+            NFAFragment inner = Pop();
+            fragments.push_back(builder.Star(move(inner)));
+        }
+        else
+        {
+            NFAFragment second = Pop();
+            NFAFragment first = Pop();
+            fragments.push_back(node.op == '.' ? builder.Concat(move(first), move(second))
+                                               : builder.Union(move(first), move(second)));
+        }
+        if (dag.Occurrences(frame.node) > 1)
+        {
+            const NFAFragment &built = fragments.back();
+            templates[frame.node] = {frame.firstState, builder.NumStates() - frame.firstState, frame.firstEdge,
+                                     builder.NumEdges() - frame.firstEdge, built.start, built.end};
+        }
+        frames.pop_back();
+    }
+    return Pop();
+}
+
+NFA DAGToNFA(const RegexDAG& dag, PipelineStats* stats)
+{
+    NFABuilder builder;
+    builder.Reserve(4 * min<size_t>(dag.TreeSize(dag.Root()), 1 << 26)); // no operator adds more than 4 edges
+    NFAFragment whole = DAGToFragment(builder, dag, stats);
+    if (stats)
+        stats->sharing = dag.Stats();
+    return builder.Finish(move(whole));
+}
+
+//---------------------------------------------------------------------
+// every final state of a single-pattern NFA accepts pattern 0
+//---------------------------------------------------------------------
+static map<int, int> SingleFinalTags(const NFA& myNFA)
+{
+    map<int, int> finalTags;
+    for (int s : myNFA.getFinalStates())
+        finalTags[s] = 0;
+    return finalTags;
+}
+
+//---------------------------------------------------------------------
+// epsilon elimination. only the start state and targets of symbol edges
+// survive; every other Thompson state only ever passes through epsilons.
+// each survivor's closure is walked once with a stamped DFS, so memory stays
+// linear in the NFA, then states that are unreachable or cannot reach a
+// final state are dropped and the rest renumbered in their old order
+//---------------------------------------------------------------------
+NFA RemoveEpsilons(const NFA& myNFA, const map<int, int>& finalTags, map<int, int>& newTags, EpsilonReport* report,
+                   size_t maxEdges)
+{
+    auto start = chrono::steady_clock::now();
+    const NFAArena &arena = myNFA.getArena();
+    int n = myNFA.NumStates();
+    int init = myNFA.getInitState();
+    if (report)
+    {
+        *report = EpsilonReport();
+        report->statesBefore = report->statesAfter = n;
+        report->edgesBefore = report->edgesAfter = arena.edges.size();
+    }
+    auto KeepInput = [&]() {
+        newTags = finalTags;
+        if (report)
+            report->ms = MillisecondsSince(start);
+        return myNFA;
+    };
+
+    vector<int> NFATags(n, -1);
+    for (const auto &entry : finalTags)
+        NFATags[entry.first] = entry.second;
+
+    vector<int> kept; // old ids of the states that can survive
+    vector<int> keptId(n, -1);
+    vector<bool> important(n, false);
+    important[init] = true;
+    for (const NFAEdge &e : arena.edges)
+        if (e.sym != '_')
+            important[e.dst] = true;
+    for (int s = 0; s < n; s++)
+    {
+        if (important[s])
         {
-        NFA nfa2 = nfa_stack.top();
-        nfa_stack.pop();
-        NFA nfa1 = nfa_stack.top();
-        nfa_stack.pop();
+            keptId[s] = kept.size();
+            kept.push_back(s);
+        }
+    }
+
+    // States whose only edge is one epsilon and that are not final are passed
+    // straight through: skip[s] is the first state down such a chain that is
+    // not, so the walks below don't retrace long chains of union ends
+    auto IsPass = [&](int s) {
+        return s < arena.NumStates() && arena.EdgesEnd(s) - arena.EdgesBegin(s) == 1 &&
+               arena.EdgesBegin(s)->sym == '_' && NFATags[s] < 0;
+    };
+    vector<int> skip(n, -1);
+    vector<bool> onPath(n, false);
+    vector<int> path;
+    for (int s = 0; s < n; s++)
+    {
+        int v = s;
+        while (skip[v] < 0 && IsPass(v) && !onPath[v])
+        {
+            onPath[v] = true;
+            path.push_back(v);
+            v = arena.EdgesBegin(v)->dst;
+        }
+        if (skip[v] < 0 && !onPath[v])
+            skip[v] = v;
+        int target = skip[v] >= 0 ? skip[v] : v; // v is on the path for an epsilon cycle
+        for (int p : path)
+        {
+            skip[p] = target;
+            onPath[p] = false;
+        }
+        path.clear();
+    }
 
-        // Add ε-transitions from nfa1's final states to nfa2's initial state
-        for (int finalState : nfa1.getFinalStates())
+    // symbol edges and tag of every kept state's closure
+    vector<NFABuilderEdge> edges;
+    vector<int> tags(kept.size(), -1);
+    vector<int> stamp(n, -1);
+    vector<int> pending;
+    for (size_t k = 0; k < kept.size(); k++)
+    {
+        pending.push_back(kept[k]);
+        stamp[kept[k]] = k;
+        while (!pending.empty())
         {
-            nfa1.AddTransition(finalState, {nfa2.getInitState()}, '_');
+            int p = pending.back();
+            pending.pop_back();
+            if (NFATags[p] >= 0 && (tags[k] < 0 || NFATags[p] < tags[k]))
+                tags[k] = NFATags[p];
+            if (p >= arena.NumStates())
+                continue;
+            for (const NFAEdge *e = arena.EdgesBegin(p); e != arena.EdgesEnd(p); e++)
+            {
+                if (e->sym != '_')
+                {
+                    if (edges.size() == maxEdges)
+                        return KeepInput();
+                    edges.push_back({(int)k, keptId[e->dst], e->sym});
+                }
+                else if (stamp[skip[e->dst]] != (int)k)
+                {
+                    stamp[skip[e->dst]] = k;
+                    pending.push_back(skip[e->dst]);
+                }
+            }
         }
+    }
 
-        // Merge nfa2 into nfa1
-        nfa1.Merge(nfa2);
+    // useful = reachable from the start and able to reach a final state
+    size_t m = kept.size();
+    vector<vector<int>> forward(m), backward(m);
+    for (const auto &e : edges)
+    {
+        forward[e.src].push_back(e.dst);
+        backward[e.dst].push_back(e.src);
+    }
+    auto Reach = [&](const vector<vector<int>> &graph, vector<int> from) {
+        vector<bool> seen(m, false);
+        for (int s : from)
+            seen[s] = true;
+        while (!from.empty())
+        {
+            int s = from.back();
+            from.pop_back();
+            for (int t : graph[s])
+                if (!seen[t])
+                {
+                    seen[t] = true;
+                    from.push_back(t);
+                }
+        }
+        return seen;
+    };
+    vector<int> finals;
+    for (size_t k = 0; k < m; k++)
+        if (tags[k] >= 0)
+            finals.push_back(k);
+    int keptInit = keptId[init];
+    vector<bool> reachable = Reach(forward, {keptInit});
+    vector<bool> live = Reach(backward, finals);
 
-        nfa1.setFinalStates(nfa2.getFinalStates());
+    vector<int> newId(m, -1);
+    int numStates = 0;
+    for (size_t k = 0; k < m; k++)
+        if ((int)k == keptInit || (reachable[k] && live[k]))
+            newId[k] = numStates++;
 
-        nfa_stack.push(nfa1);
+    vector<NFABuilderEdge> usefulEdges;
+    set<char> alphabet;
+    for (const auto &e : edges)
+    {
+        if (newId[e.src] >= 0 && newId[e.dst] >= 0)
+        {
+            usefulEdges.push_back({newId[e.src], newId[e.dst], e.sym});
+            alphabet.insert(e.sym);
+        }
     }
-        else if (c == '|')
+    set<int> newFinals;
+    newTags.clear();
+    for (size_t k = 0; k < m; k++)
+    {
+        if (newId[k] >= 0 && tags[k] >= 0)
         {
-            NFA nfa2 = nfa_stack.top();
-            nfa_stack.pop();
-            NFA nfa1 = nfa_stack.top();
-            nfa_stack.pop();
+            newFinals.insert(newId[k]);
+            newTags[newId[k]] = tags[k];
+        }
+    }
 
-            nfa1.ShiftStates(1);
-            nfa2.ShiftStates(stateCount - 3);
+    shared_ptr<const NFAArena> result = NFABuilder::BuildArena(numStates, usefulEdges);
+    if (report)
+    {
+        report->removed = true;
+        report->statesAfter = numStates;
+        report->edgesAfter = result->edges.size();
+        report->ms = MillisecondsSince(start);
+    }
+    return NFA(result, alphabet, newId[keptInit], newFinals);
+}
 
-            int newStart = 0;
-            int newFinal = stateCount + 1;
-            stateCount = newFinal + 1;
+NFA RemoveEpsilons(const NFA& myNFA, EpsilonReport* report, size_t maxEdges)
+{
+    map<int, int> newTags;
+    return RemoveEpsilons(myNFA, SingleFinalTags(myNFA), newTags, report, maxEdges);
+}
 
-            // Create the new union NFA.
-            NFA newNFA(nfa1.getAlpha(), newStart, {newFinal});
+//---------------------------------------------------------------------
+// convert a regular expression in postfix to an NFA using Thompson's construction
+//---------------------------------------------------------------------
+NFA PostfixToNFA(const string& postfix)
+{
+    NFABuilder builder;
+    builder.Reserve(4 * postfix.size()); // no operator adds more than 4 edges
+    NFAFragment whole = PostfixToFragment(builder, postfix);
+    return builder.Finish(move(whole));
+}
 
-            // From the new start state, add ε-transitions to both NFAs initial states.
-            newNFA.AddTransition(newStart, {nfa1.getInitState(), nfa2.getInitState()}, '_');
+//---------------------------------------------------------------------
+// union of many regexes in one NFA: a new start state with ε-transitions
+// to every pattern. finalTags maps each pattern's final state to its index
+//---------------------------------------------------------------------
+NFA PatternsToNFA(const vector<string>& infixes, map<int, int>& finalTags)
+{
+    NFABuilder builder;
+    int start = builder.AddState();
+    set<int> finals;
+    finalTags.clear();
+    for (size_t i = 0; i < infixes.size(); i++)
+    {
+        NFAFragment fragment = PostfixToFragment(builder, InfixToPostfix(infixes[i]));
+        builder.AddEdge(start, fragment.start, '_');
+        finals.insert(fragment.end);
+        finalTags[fragment.end] = i;
+    }
+    NFA nfa = builder.Finish(NFAFragment(start, start));
+    nfa.setFinalStates(finals);
+    return nfa;
+}
 
-            // Merge the two NFAs into newNFA.
-            newNFA.Merge(nfa1);
-            newNFA.Merge(nfa2);
+//---------------------------------------------------------------------
+// what every subset construction needs from the NFA: the symbols, each
+// state's symbol edges as (symbol index, destination), each state's
+// epsilon closure and its pattern tag, or -1 if it is not final
+//---------------------------------------------------------------------
+struct SubsetInput
+{
+    vector<char> symbols;
+    vector<vector<pair<int, int>>> edges;
+    vector<StateSet> closures; // empty for an epsilon-free NFA, where each closure is the state itself
+    vector<int> NFATags;
+    size_t bytesPerState; // working memory per DFA state, for the limits
+};
 
-            // For each final state in nfa1/2, add an ε-transition to the new final state.
-            for (int finalState : nfa1.getFinalStates())
-            {
-                newNFA.AddTransition(finalState, {newFinal}, '_');
-            }
-            for (int finalState : nfa2.getFinalStates())
-            {
-                newNFA.AddTransition(finalState, {newFinal}, '_');
-            }
+static SubsetInput PrepareSubset(const NFA& myNFA, const map<int, int>& finalTags, PipelineStats* stats)
+{
+    int numNFAStates = myNFA.NumStates();
+    SubsetInput input;
+    map<char, int> symbolIndex;
+    for (char a : myNFA.getAlpha())
+    {
+        if (a != '_') // Skip epsilon transitions
+        {
+            symbolIndex[a] = input.symbols.size();
+            input.symbols.push_back(a);
+        }
+    }
+
+    const NFAArena &arena = myNFA.getArena();
+    input.edges.resize(numNFAStates);
+    for (int s = 0; s < arena.NumStates(); s++)
+    {
+        for (const NFAEdge *e = arena.EdgesBegin(s); e != arena.EdgesEnd(s); e++)
+        {
+            auto found = symbolIndex.find(e->sym);
+            if (found != symbolIndex.end())
+                input.edges[s].push_back({found->second, e->dst});
+        }
+    }
 
-            nfa_stack.push(newNFA);
+    // Each state's epsilon closure is computed exactly once
+    if (myNFA.HasEpsilons())
+    {
+        auto closureStart = chrono::steady_clock::now();
+        input.closures = myNFA.EpsilonClosures();
+        if (stats)
+        {
+            stats->closureMs += MillisecondsSince(closureStart);
+            stats->closureComputations += input.closures.size();
         }
     }
-    return nfa_stack.top();
+    input.NFATags.assign(numNFAStates, -1);
+    for (const auto &entry : finalTags)
+        input.NFATags[entry.first] = entry.second;
+
+    // A DFA state's set as a hash map key, its Dstates pointer and its row
+    input.bytesPerState = sizeof(StateSet) + (numNFAStates + 63) / 64 * sizeof(uint64_t) + 4 * sizeof(void *) +
+                          sizeof(const StateSet *) + sizeof(vector<int>) + input.symbols.size() * sizeof(int);
+    return input;
+}
+
+// set |= closure of s
+static void AddClosure(const SubsetInput& input, StateSet& set, int s)
+{
+    if (input.closures.empty())
+        set.Insert(s);
+    else
+        set.UnionWith(input.closures[s]);
+}
+
+static void CheckLimits(const CompileLimits& limits, size_t states, size_t bytesPerState,
+                        chrono::steady_clock::time_point start)
+{
+    if (limits.Unlimited())
+        return;
+    size_t bytes = states * bytesPerState;
+    double ms = MillisecondsSince(start);
+    if (limits.max_states && states > limits.max_states)
+        throw DFALimitExceeded(CompileLimit::STATES, states, bytes, ms);
+    if (limits.max_bytes && bytes > limits.max_bytes)
+        throw DFALimitExceeded(CompileLimit::MEMORY, states, bytes, ms);
+    if (limits.max_ms && ms > limits.max_ms)
+        throw DFALimitExceeded(CompileLimit::TIME, states, bytes, ms);
+}
+
+// A DFA state is final if it contains any final NFA state
+static int TagOf(const StateSet& set, const vector<int>& NFATags)
+{
+    int tag = -1;
+    set.ForEach([&](int s) {
+        if (NFATags[s] >= 0 && (tag < 0 || NFATags[s] < tag))
+            tag = NFATags[s];
+    });
+    return tag;
 }
 
 //---------------------------------------------------------------------
-// convert a NFA to DFA using subset construction
+// subset construction. DFA states are numbered in the order they are
+// discovered, the start state is 0. rows[s][i] is the target of state s
+// on symbols[i], or -1 if there is none. finalTags maps final NFA states
+// to pattern ids; a DFA state takes the smallest id among its members,
+// or -1 if it has no final NFA state
 //---------------------------------------------------------------------
-DFA NFAtoDFA(const NFA& myNFA)
+struct SubsetResult
+{
+    vector<char> symbols;
+    vector<vector<int>> rows;
+    vector<int> tags;
+};
+
+static SubsetResult SubsetConstruction(const NFA& myNFA, const map<int, int>& finalTags,
+                                       PipelineStats* stats, const CompileLimits& limits)
 {
-    map<int, map<char, set<int>>> Ntran = myNFA.getNFATransitions();
-    int NFAStart = myNFA.getInitState();
-    set<int> NFAFinals = myNFA.getFinalStates();
-    set<char> alpha = myNFA.getAlpha();
+    auto start = chrono::steady_clock::now();
+    int numNFAStates = myNFA.NumStates();
+    SubsetInput input = PrepareSubset(myNFA, finalTags, stats);
+    size_t numSymbols = input.symbols.size();
 
-    map<set<int>, map<char, set<int>>> Dtran; // DFA transition map
-    map<set<int>, int> stateMapping;          // Maps NFA states to its corresponding DFA state
-    queue<set<int>> unmarkedStates;           // States yet to be processed
-    set<set<int>> Dstates;                    // DFA states
+    SubsetResult result;
+    result.symbols = input.symbols;
+    unordered_map<StateSet, int, StateSetHash> stateMapping; // Maps NFA states to its corresponding DFA state
+    vector<const StateSet *> Dstates;                        // DFA states in discovery order
 
     // Create initial DFA state from NFA initial state 
-    set<int> startSet = {NFAStart};
-    set<int> startClosure = myNFA.EpsilonClosure(startSet);
-    Dstates.insert(startClosure);
-    unmarkedStates.push(startClosure);
-    stateMapping[startClosure] = 0;
+    StateSet initial(numNFAStates);
+    AddClosure(input, initial, myNFA.getInitState());
+    auto inserted = stateMapping.emplace(move(initial), 0);
+    Dstates.push_back(&inserted.first->first);
+    result.rows.push_back(vector<int>(numSymbols, -1));
+
+    // Process states in discovery order, which is the order a FIFO queue of unmarked states gives
+    vector<StateSet> U(numSymbols, StateSet(numNFAStates));
+    for (size_t src = 0; src < Dstates.size(); src++)
+    {
+        CheckLimits(limits, Dstates.size(), input.bytesPerState, start);
+
+        // One pass over T builds the epsilon closure of move(T, a) for every symbol a
+        for (StateSet &u : U)
+            u.Clear();
+        Dstates[src]->ForEach([&](int s) {
+            for (const auto &edge : input.edges[s])
+                AddClosure(input, U[edge.first], edge.second);
+        });
+
+        for (size_t i = 0; i < numSymbols; i++)
+        {
+            if (U[i].Empty())
+                continue;
+            if (stats)
+                stats->closureComputations++;
+            auto found = stateMapping.find(U[i]);
+            if (found == stateMapping.end()) // If the DFA set isn't in our set of DFAs, add it to be processed
+            {
+                found = stateMapping.emplace(U[i], (int)Dstates.size()).first;
+                Dstates.push_back(&found->first);
+                result.rows.push_back(vector<int>(numSymbols, -1));
+            }
+            result.rows[src][i] = found->second;
+        }
+    }
 
-    int stateCount = 0;
-    DFA myDFA(alpha, {0}, {});
+    result.tags.resize(Dstates.size());
+    for (size_t id = 0; id < Dstates.size(); id++)
+        result.tags[id] = TagOf(*Dstates[id], input.NFATags);
+    return result;
+}
+
+//---------------------------------------------------------------------
+// the same construction spread over a thread pool. every worker owns a
+// deque of unexpanded DFA states: it pushes the states it discovers and
+// pops from the back, and when its deque runs dry it steals from the front
+// of the others'. new sets are deduplicated in a sharded hash map. states
+// are numbered afterwards by a breadth-first walk from the start state over
+// the rows in symbol order, which is exactly the order the sequential
+// construction discovers them in, so both give identical DFAs
+//---------------------------------------------------------------------
+struct ParallelDState
+{
+    StateSet set;
+    vector<ParallelDState *> row; // targets per symbol, null if none
+};
+
+class ConcurrentStateMap
+{
+public:
+    // the DFA state for set, and whether this call created it
+    pair<ParallelDState *, bool> Insert(const StateSet& set)
+    {
+        Shard &shard = shards[set.Hash() % NUM_SHARDS];
+        lock_guard<mutex> guard(shard.lock);
+        auto found = shard.ids.find(&set);
+        if (found != shard.ids.end())
+            return {found->second, false};
+        shard.states.push_back({set, {}});
+        ParallelDState *state = &shard.states.back();
+        shard.ids.emplace(&state->set, state);
+        return {state, true};
+    }
 
-    // Process all unmarked states
-    while (!unmarkedStates.empty())
+private:
+    static const size_t NUM_SHARDS = 64;
+
+    // the map is keyed by the set inside its ParallelDState, so each set is stored once
+    struct SetPointerHash
+    {
+        size_t operator()(const StateSet *set) const { return set->Hash(); }
+    };
+    struct SetPointerEqual
+    {
+        bool operator()(const StateSet *a, const StateSet *b) const { return *a == *b; }
+    };
+    struct Shard
     {
-        set<int> T = unmarkedStates.front();
-        unmarkedStates.pop();
+        mutex lock;
+        unordered_map<const StateSet *, ParallelDState *, SetPointerHash, SetPointerEqual> ids;
+        deque<ParallelDState> states; // stable addresses
+    };
+    Shard shards[NUM_SHARDS];
+};
+
+struct WorkDeque
+{
+    mutex lock;
+    deque<ParallelDState *> items;
+};
+
+static SubsetResult ParallelSubsetConstruction(const NFA& myNFA, ThreadPool& pool, PipelineStats* stats,
+                                               const CompileLimits& limits)
+{
+    auto start = chrono::steady_clock::now();
+    int numNFAStates = myNFA.NumStates();
+    SubsetInput input = PrepareSubset(myNFA, SingleFinalTags(myNFA), stats);
+    size_t numSymbols = input.symbols.size();
+    size_t numWorkers = pool.Size();
+
+    ConcurrentStateMap stateMapping;
+    vector<WorkDeque> work(numWorkers);
+    atomic<size_t> numStates(1);
+    atomic<size_t> unfinished(1);    // discovered but not yet expanded
+    atomic<size_t> queued(1);        // sitting in a work deque
+    atomic<size_t> closureComputations(0);
+    atomic<bool> failed(false);
+
+    // workers with nothing to take sleep here until states are queued or the
+    // construction is over. Wake only takes the lock when someone sleeps
+    mutex idleLock;
+    condition_variable idle;
+    atomic<size_t> sleepers(0);
+    auto Wake = [&]() {
+        if (sleepers.load() == 0)
+            return;
+        lock_guard<mutex> guard(idleLock);
+        idle.notify_all();
+    };
 
-        // For each input symbol
-        for (char a : alpha)
+    StateSet initialSet(numNFAStates);
+    AddClosure(input, initialSet, myNFA.getInitState());
+    ParallelDState *initial = stateMapping.Insert(initialSet).first;
+    work[0].items.push_back(initial);
+
+    auto Take = [&](size_t self) -> ParallelDState * {
+        for (size_t k = 0; k < numWorkers; k++)
+        {
+            WorkDeque &victim = work[(self + k) % numWorkers];
+            lock_guard<mutex> guard(victim.lock);
+            if (victim.items.empty())
+                continue;
+            ParallelDState *state;
+            if (k == 0) // own deque: newest first
+            {
+                state = victim.items.back();
+                victim.items.pop_back();
+            }
+            else // steal the oldest
+            {
+                state = victim.items.front();
+                victim.items.pop_front();
+            }
+            queued--;
+            return state;
+        }
+        return nullptr;
+    };
+
+    pool.ParallelFor(numWorkers, [&](size_t self) {
+        vector<StateSet> U(numSymbols, StateSet(numNFAStates));
+        size_t closures = 0;
+        while (unfinished.load() > 0 && !failed.load())
         {
-            if (a == '_') { // Skip epsilon transitions
+            ParallelDState *state = Take(self);
+            if (!state)
+            {
+                unique_lock<mutex> lock(idleLock);
+                sleepers++;
+                idle.wait(lock, [&]() { return queued.load() > 0 || unfinished.load() == 0 || failed.load(); });
+                sleepers--;
                 continue;
             }
+            try
+            {
+                CheckLimits(limits, numStates.load(), input.bytesPerState, start);
+            }
+            catch (...)
+            {
+                failed = true;
+                Wake();
+                closureComputations += closures;
+                throw;
+            }
+
+            for (StateSet &u : U)
+                u.Clear();
+            state->set.ForEach([&](int s) {
+                for (const auto &edge : input.edges[s])
+                    AddClosure(input, U[edge.first], edge.second);
+            });
+
+            vector<ParallelDState *> row(numSymbols, nullptr);
+            vector<ParallelDState *> discovered;
+            for (size_t i = 0; i < numSymbols; i++)
+            {
+                if (U[i].Empty())
+                    continue;
+                closures++;
+                auto inserted = stateMapping.Insert(U[i]);
+                row[i] = inserted.first;
+                if (inserted.second)
+                    discovered.push_back(inserted.first);
+            }
+            state->row = move(row);
 
-            set<int> U = myNFA.EpsilonClosure(myNFA.move(T, a)); // Get states reachable by the input symbol(using move(T,a)) then by epsilon
-            if (!U.empty())
+            if (!discovered.empty())
             {
-                if (Dstates.count(U) == 0) // If the DFA set isn't in our set of DFAs, add it to be processed
+                numStates += discovered.size();
+                unfinished += discovered.size();
                 {
-                    Dstates.insert(U);
-                    unmarkedStates.push(U);
-                    stateCount++;
-                    stateMapping[U] = stateCount;
+                    lock_guard<mutex> guard(work[self].lock);
+                    queued += discovered.size();
+                    work[self].items.insert(work[self].items.end(), discovered.begin(), discovered.end());
                 }
-                Dtran[T][a] = U;
+                Wake();
             }
+            if (--unfinished == 0)
+                Wake();
         }
+        closureComputations += closures;
+    });
+    if (stats)
+        stats->closureComputations += closureComputations;
+
+    // Deterministic numbering: breadth-first from the start state, symbols in order
+    unordered_map<const ParallelDState *, int> ids;
+    vector<const ParallelDState *> order = {initial};
+    ids[initial] = 0;
+    for (size_t src = 0; src < order.size(); src++)
+        for (const ParallelDState *target : order[src]->row)
+            if (target && ids.emplace(target, (int)order.size()).second)
+                order.push_back(target);
+
+    SubsetResult result;
+    result.symbols = input.symbols;
+    result.rows.assign(order.size(), vector<int>(numSymbols, -1));
+    result.tags.resize(order.size());
+    for (size_t id = 0; id < order.size(); id++)
+    {
+        for (size_t i = 0; i < numSymbols; i++)
+            if (order[id]->row[i])
+                result.rows[id][i] = ids[order[id]->row[i]];
+        result.tags[id] = TagOf(order[id]->set, input.NFATags);
     }
+    return result;
+}
+
+//---------------------------------------------------------------------
+// convert a NFA straight to the flat matching table
+//---------------------------------------------------------------------
+CompiledDFA NFAtoCompiledDFA(const NFA& myNFA)
+{
+    return NFAtoCompiledDFA(myNFA, SingleFinalTags(myNFA));
+}
+
+//---------------------------------------------------------------------
+// same, with accepting DFA states tagged by the pattern ids in finalTags
+//---------------------------------------------------------------------
+CompiledDFA NFAtoCompiledDFA(const NFA& myNFA, const map<int, int>& finalTags, const CompileLimits& limits)
+{
+    SubsetResult subset = SubsetConstruction(myNFA, finalTags, nullptr, limits);
+    return CompiledDFA(subset.symbols, subset.rows, subset.tags, 0);
+}
+
+//---------------------------------------------------------------------
+// the map form of a subset construction for JSON export plus its table
+//---------------------------------------------------------------------
+static DFA SubsetToDFA(const NFA& myNFA, const SubsetResult& subset, const Prefilter& prefilter)
+{
+    DFA myDFA(myNFA.getAlpha(), {0}, {});
 
-    // Convert state set transitions to DFA state numbers
-    for (auto &row : Dtran)
+    // The map form is only kept for JSON export
+    set<int> DFAFinals;
+    for (size_t src = 0; src < subset.rows.size(); src++)
     {
-        int src = stateMapping[row.first];
-        for (auto &trans : row.second)
+        for (size_t i = 0; i < subset.symbols.size(); i++)
         {
-            int dst = stateMapping[trans.second];
-            myDFA.AddTransition(src, dst, trans.first);
+            if (subset.rows[src][i] >= 0)
+                myDFA.AddTransition(src, subset.rows[src][i], subset.symbols[i]);
         }
+        if (subset.tags[src] >= 0)
+            DFAFinals.insert(src);
     }
+    myDFA.setFinalStates(DFAFinals);
+    myDFA.setPrefilter(prefilter); // before the table exists, so nothing is copied
 
-    set<int> DFAFinals;
-    for (auto &entry : stateMapping)
+    // Matching runs on the table built directly from the dense rows
+    myDFA.setCompiled(CompiledDFA(subset.symbols, subset.rows, subset.tags, 0));
+    myDFA.Reset();
+    return myDFA;
+}
+
+//---------------------------------------------------------------------
+// convert a NFA to DFA using subset construction, sequentially or with
+// the parallel construction when given a pool
+//---------------------------------------------------------------------
+static DFA NFAtoDFA(const NFA& myNFA, ThreadPool* pool, PipelineStats* stats, const CompileLimits& limits,
+                    const Prefilter& prefilter)
+{
+    auto start = chrono::steady_clock::now();
+    double closureMsBefore = stats ? stats->closureMs : 0;
+    SubsetResult subset = pool ? ParallelSubsetConstruction(myNFA, *pool, stats, limits)
+                               : SubsetConstruction(myNFA, SingleFinalTags(myNFA), stats, limits);
+    DFA myDFA = SubsetToDFA(myNFA, subset, prefilter);
+
+    if (stats)
+    {
+        stats->subsetMs += MillisecondsSince(start) - (stats->closureMs - closureMsBefore);
+        stats->dfaStates = subset.rows.size();
+        stats->dfaEdges = myDFA.NumTransitions();
+    }
+    return myDFA;
+}
+
+DFA NFAtoDFA(const NFA& myNFA, PipelineStats* stats, const CompileLimits& limits, const Prefilter& prefilter)
+{
+    return NFAtoDFA(myNFA, nullptr, stats, limits, prefilter);
+}
+
+DFA NFAtoDFAParallel(const NFA& myNFA, ThreadPool& pool, PipelineStats* stats, const CompileLimits& limits,
+                     const Prefilter& prefilter)
+{
+    return NFAtoDFA(myNFA, &pool, stats, limits, prefilter);
+}
+
+//---------------------------------------------------------------------
+// refinable partition of the states 0..n-1 used by Hopcroft's algorithm.
+// each block is a contiguous range of elems; marked states are moved to
+// the front of their block so a split is just a boundary change
+//---------------------------------------------------------------------
+struct Partition
+{
+    vector<int> elems, loc, blockOf;
+    vector<int> first, end, mid; // per block, [first, mid) is the marked part
+    vector<int> touched;         // blocks with at least one marked state
+
+    Partition(int n, const vector<bool> &accepting)
+        : elems(n), loc(n), blockOf(n)
     {
-        const set<int> &stateSet = entry.first;
-        int dfaStateID = entry.second;
-        // For each final NFA state, make the DFA state final 
-        for (int nfaState : stateSet)
+        // accepting states first, so the initial blocks are F and Q \ F
+        int pos = 0;
+        for (int pass = 0; pass < 2; pass++)
         {
-            if (NFAFinals.find(nfaState) != NFAFinals.end())
+            int begin = pos;
+            for (int s = 0; s < n; s++)
+            {
+                if (accepting[s] == (pass == 0))
+                {
+                    elems[pos] = s;
+                    loc[s] = pos++;
+                    blockOf[s] = first.size();
+                }
+            }
+            if (pos > begin)
             {
-                DFAFinals.insert(dfaStateID);
-                break;
+                first.push_back(begin);
+                end.push_back(pos);
+                mid.push_back(begin);
             }
         }
     }
-    myDFA.setFinalStates(DFAFinals);
-    return myDFA;
+
+    int Size(int b) const { return end[b] - first[b]; }
+
+    void Mark(int s)
+    {
+        int b = blockOf[s];
+        int i = loc[s];
+        if (i < mid[b])
+            return; // already marked
+        if (mid[b] == first[b])
+            touched.push_back(b);
+        int other = elems[mid[b]];
+        swap(elems[i], elems[mid[b]]);
+        loc[other] = i;
+        loc[s] = mid[b]++;
+    }
+
+    // split off the marked part of b as a new block, -1 if nothing to split
+    int Split(int b)
+    {
+        if (mid[b] == end[b])
+        {
+            mid[b] = first[b]; // the whole block was marked
+            return -1;
+        }
+        int nb = first.size();
+        first.push_back(first[b]);
+        end.push_back(mid[b]);
+        mid.push_back(first[b]);
+        for (int i = first[nb]; i < end[nb]; i++)
+            blockOf[elems[i]] = nb;
+        first[b] = mid[b];
+        return nb;
+    }
+};
+
+//---------------------------------------------------------------------
+// minimize a DFA with Hopcroft's O(n log n) partition refinement.
+// runs over byte classes of the flat table with an explicit dead state,
+// so states that can never accept are dropped from the result
+//---------------------------------------------------------------------
+DFA MinimizeDFA(const DFA& myDFA, MinimizeReport* report)
+{
+    set<int> initStates = myDFA.getInitStates();
+    int start = initStates.empty() ? 0 : *initStates.begin();
+    const map<int, map<char, int>> &Dtran = myDFA.getDFATransitions();
+    CompiledDFA table(Dtran, start, myDFA.getFinalStates());
+
+    // Symbols actually used, and one representative byte per byte class
+    set<char> alphabet;
+    for (const auto &row : Dtran)
+        for (const auto &trans : row.second)
+            alphabet.insert(trans.first);
+    int numClasses = table.AlphabetWidth();
+    vector<int> classRep(numClasses, -1);
+    for (char a : alphabet)
+    {
+        int cls = table.ByteClasses()[(unsigned char)a];
+        if (classRep[cls] < 0)
+            classRep[cls] = (unsigned char)a;
+    }
+
+    // States 0..n-1 of the table plus the dead state n
+    int n = table.NumStates();
+    int dead = n;
+    auto Target = [&](int s, int cls) {
+        if (s == dead)
+            return dead;
+        uint32_t dst = table.Next(s, classRep[cls]);
+        return dst == CompiledDFA::DEAD ? dead : (int)dst;
+    };
+
+    // Inverse transitions per class
+    vector<vector<vector<int>>> inverse(numClasses, vector<vector<int>>(n + 1));
+    for (int cls = 0; cls < numClasses; cls++)
+        if (classRep[cls] >= 0)
+            for (int s = 0; s <= n; s++)
+                inverse[cls][Target(s, cls)].push_back(s);
+
+    vector<bool> accepting(n + 1, false);
+    for (int s = 0; s < n; s++)
+        accepting[s] = table.IsAccepting(s);
+    Partition P(n + 1, accepting);
+
+    // Worklist of (block, class) splitters
+    vector<pair<int, int>> work;
+    vector<vector<bool>> inWork;
+    auto Push = [&](int b, int cls) {
+        while ((int)inWork.size() <= b)
+            inWork.push_back(vector<bool>(numClasses, false));
+        if (!inWork[b][cls])
+        {
+            inWork[b][cls] = true;
+            work.push_back({b, cls});
+        }
+    };
+    int smaller = (P.first.size() == 2 && P.Size(1) < P.Size(0)) ? 1 : 0;
+    for (int cls = 0; cls < numClasses; cls++)
+        if (classRep[cls] >= 0)
+            Push(smaller, cls);
+
+    vector<int> splitter;
+    while (!work.empty())
+    {
+        auto [A, cls] = work.back();
+        work.pop_back();
+        inWork[A][cls] = false;
+
+        // Mark every state with a cls-transition into A
+        splitter.assign(P.elems.begin() + P.first[A], P.elems.begin() + P.end[A]);
+        for (int t : splitter)
+            for (int s : inverse[cls][t])
+                P.Mark(s);
+
+        // Split every touched block and queue the new splitters
+        vector<int> touched;
+        touched.swap(P.touched);
+        for (int Y : touched)
+        {
+            int Z = P.Split(Y);
+            if (Z < 0)
+                continue;
+            for (int c = 0; c < numClasses; c++)
+            {
+                if (classRep[c] < 0)
+                    continue;
+                if ((int)inWork.size() > Y && inWork[Y][c])
+                    Push(Z, c);
+                else
+                    Push(P.Size(Z) < P.Size(Y) ? Z : Y, c);
+            }
+        }
+    }
+
+    // Number the surviving blocks in BFS order from the start block
+    int deadBlock = P.blockOf[dead];
+    int startBlock = P.blockOf[table.Start()];
+    map<int, int> newId;
+    vector<int> order;
+    newId[startBlock] = 0;
+    order.push_back(startBlock);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        int rep = P.elems[P.first[order[i]]];
+        for (char a : alphabet)
+        {
+            int dst = P.blockOf[Target(rep, table.ByteClasses()[(unsigned char)a])];
+            if (dst != deadBlock && newId.count(dst) == 0)
+            {
+                newId[dst] = order.size();
+                order.push_back(dst);
+            }
+        }
+    }
+
+    DFA minDFA(alphabet, {0}, {});
+    set<int> finals;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        int rep = P.elems[P.first[order[i]]];
+        if (order[i] == deadBlock)
+            continue; // empty language, keep a lone start state
+        for (char a : alphabet)
+        {
+            int dst = P.blockOf[Target(rep, table.ByteClasses()[(unsigned char)a])];
+            if (dst != deadBlock)
+                minDFA.AddTransition(i, newId[dst], a);
+        }
+        if (accepting[rep])
+            finals.insert(i);
+    }
+    minDFA.setFinalStates(finals);
+    minDFA.setPrefilter(myDFA.getPrefilter()); // same language, same prefilter
+    minDFA.Reset();
+
+    if (report)
+    {
+        report->statesBefore = n;
+        report->statesAfter = order.size();
+    }
+    return minDFA;
 }
 
 //---------------------------------------------------------------------
-// helper method that calls the other methods to convert regex to DFA
+// the pipeline behind regexToDFA, the visualizer and --batch
 //---------------------------------------------------------------------
-DFA regexToDFA(const string& infix) {
+CompiledAutomata compileRegex(const string& infix, const CompileOptions& options, PipelineStats* stats,
+                              ThreadPool* pool) {
+    // an AllocScope resets the process-wide peak, so only open one when the
+    // caller asked for it and so promised no other compile overlaps
+    optional<AllocScope> memory;
+    if (stats && options.measurePeak)
+        memory.emplace();
+    PipelineStats local;
+    PipelineStats& s = stats ? *stats : local;
+    auto start = chrono::steady_clock::now();
+    auto stageStart = start;
+    auto Stage = [&](double PipelineStats::*field) {
+        s.*field += MillisecondsSince(stageStart);
+        stageStart = chrono::steady_clock::now();
+    };
+
     string postfix = InfixToPostfix(infix);
-    NFA resultNFA = PostfixToNFA(postfix);
-    DFA resultDFA = NFAtoDFA(resultNFA);
-    return resultDFA;
-}
\ No newline at end of file
+    RegexDAG dag = RegexDAG::FromPostfix(postfix);
+    Stage(&PipelineStats::parseMs);
+    NFA thompson = DAGToNFA(dag, &s);
+    Stage(&PipelineStats::thompsonMs);
+    EpsilonReport epsilon;
+    NFA epsFree = RemoveEpsilons(thompson, &epsilon, EpsilonEdgeBudget(thompson));
+    Stage(&PipelineStats::epsilonMs);
+    // the prefilter goes in with the table; minimization carries it over
+    Prefilter prefilter = Prefilter::FromDAG(dag);
+    DFA dfa = pool ? NFAtoDFAParallel(epsFree, *pool, &s, options.limits, prefilter)
+                   : NFAtoDFA(epsFree, &s, options.limits, prefilter);
+
+    stageStart = chrono::steady_clock::now();
+    if (options.minimize)
+        dfa = MinimizeDFA(dfa);
+    Stage(&PipelineStats::minimizeMs);
+
+    s.totalMs += MillisecondsSince(start);
+    s.nfaStates = thompson.NumStates();
+    s.nfaEdges = thompson.getArena().edges.size();
+    s.epsFreeStates = epsilon.statesAfter;
+    s.epsFreeEdges = epsilon.edgesAfter;
+    s.minDfaStates = dfa.getCompiled().NumStates();
+    s.minDfaEdges = dfa.NumTransitions();
+    if (memory)
+        s.peakBytes = memory->PeakBytes();
+    return {options.epsilonFree ? move(epsFree) : move(thompson), move(dfa)};
+}
+
+//---------------------------------------------------------------------
+// helper method that calls the other methods to convert regex to DFA
+//---------------------------------------------------------------------
+DFA regexToDFA(const string& infix, bool minimize, MinimizeReport* report, PipelineStats* stats,
+               const CompileLimits& limits) {
+    CompileOptions options;
+    options.minimize = minimize;
+    options.limits = limits;
+    options.measurePeak = stats != nullptr;
+    PipelineStats local;
+    PipelineStats* s = stats ? stats : &local;
+    DFA dfa = move(compileRegex(infix, options, s).dfa);
+    if (report)
+    {
+        report->statesBefore = s->dfaStates;
+        report->statesAfter = s->minDfaStates;
+    }
+    return dfa;
+}
@@ -2,12 +2,122 @@
 #define CONVERTER_HPP
 
 #include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
 #include "../include/NFA.h"
+#include "../include/NFABuilder.h"
 #include "../include/DFA.h"
+#include "../include/CompileLimits.h"
+#include "../include/ThreadPool.h"
+#include "../include/RegexDAG.h"
 
+// throws invalid_argument on unbalanced parentheses
 std::string InfixToPostfix(const std::string& infix);
+NFAFragment PostfixToFragment(NFABuilder& builder, const std::string& postfix);
 NFA PostfixToNFA(const std::string& postfix);
-DFA NFAtoDFA(const NFA& nfa);
-DFA regexToDFA(const std::string& infix);
+NFA PatternsToNFA(const std::vector<std::string>& infixes, std::map<int, int>& finalTags);
+
+// where compiling one regex spent its time and memory. times are in ms
+struct PipelineStats
+{
+    double parseMs = 0;      // InfixToPostfix and the expression DAG
+    double thompsonMs = 0;   // Thompson construction
+    double epsilonMs = 0;    // RemoveEpsilons
+    double closureMs = 0;    // epsilon closure of every NFA state
+    double subsetMs = 0;     // subset construction and DFA tables, closures excluded
+    double minimizeMs = 0;
+    double totalMs = 0;
+    size_t nfaStates = 0;
+    size_t nfaEdges = 0;     // epsilon edges included
+    size_t epsFreeStates = 0; // NFA after epsilon elimination
+    size_t epsFreeEdges = 0;
+    size_t dfaStates = 0;    // as built by subset construction
+    size_t dfaEdges = 0;
+    size_t minDfaStates = 0; // after minimization, same as dfa* without it
+    size_t minDfaEdges = 0;
+    size_t closureComputations = 0; // per-state closures plus closures of move(T, a)
+    RegexDAGStats sharing;   // repeated subexpressions found by the DAG
+    size_t clonedStates = 0; // NFA states copied from an earlier occurrence instead of rebuilt
+    size_t peakBytes = 0;    // heap high-water mark, 0 unless AllocTracker::Enabled()
+};
+
+// Thompson construction over the DAG. each repeated subexpression is built
+// once and copied for its other occurrences; the NFA equals PostfixToNFA's
+NFAFragment DAGToFragment(NFABuilder& builder, const RegexDAG& dag, PipelineStats* stats = nullptr);
+NFA DAGToNFA(const RegexDAG& dag, PipelineStats* stats = nullptr);
+
+// subset construction throws DFALimitExceeded when a bound in limits trips.
+// the table is built with prefilter, so setting it later is not needed
+DFA NFAtoDFA(const NFA& nfa, PipelineStats* stats = nullptr, const CompileLimits& limits = CompileLimits(),
+             const Prefilter& prefilter = Prefilter());
+// same DFA, same state numbering, with the subset construction spread over the pool
+DFA NFAtoDFAParallel(const NFA& nfa, ThreadPool& pool, PipelineStats* stats = nullptr,
+                     const CompileLimits& limits = CompileLimits(), const Prefilter& prefilter = Prefilter());
+CompiledDFA NFAtoCompiledDFA(const NFA& nfa);
+CompiledDFA NFAtoCompiledDFA(const NFA& nfa, const std::map<int, int>& finalTags,
+                             const CompileLimits& limits = CompileLimits());
+
+// NFA sizes before and after epsilon elimination
+struct EpsilonReport
+{
+    bool removed = false;    // false if the edge budget kept the input NFA
+    size_t statesBefore = 0;
+    size_t edgesBefore = 0;
+    size_t statesAfter = 0;
+    size_t edgesAfter = 0;
+    double ms = 0;
+};
+
+// an equivalent NFA without epsilon edges. its states are the start state and
+// the targets of symbol edges that are reachable and can reach a final state;
+// each gets the symbol edges of its old epsilon closure and is final if the
+// closure held a final state. closures can overlap heavily (nested stars), so
+// when more than maxEdges symbol edges would be needed the input is returned
+NFA RemoveEpsilons(const NFA& nfa, EpsilonReport* report = nullptr, size_t maxEdges = SIZE_MAX);
+// same for a tagged NFA, newTags gets the smallest tag of each new final state's
+// closure, or a copy of finalTags when the input is returned
+NFA RemoveEpsilons(const NFA& nfa, const std::map<int, int>& finalTags, std::map<int, int>& newTags,
+                   EpsilonReport* report = nullptr, size_t maxEdges = SIZE_MAX);
+
+// the edge budget the pipeline gives RemoveEpsilons: beyond twice the
+// Thompson edges the subset construction is faster on the Thompson NFA
+inline size_t EpsilonEdgeBudget(const NFA& nfa) { return 2 * nfa.getArena().edges.size(); }
+
+// DFA state counts before and after minimization
+struct MinimizeReport
+{
+    size_t statesBefore = 0;
+    size_t statesAfter = 0;
+};
+
+DFA MinimizeDFA(const DFA& dfa, MinimizeReport* report = nullptr);
+
+// how compileRegex builds one regex
+struct CompileOptions
+{
+    bool minimize = true;
+    bool epsilonFree = false; // return the epsilon-free NFA rather than the Thompson one
+    CompileLimits limits;
+    bool measurePeak = true;  // fill stats->peakBytes, which needs an AllocScope no other compile overlaps
+};
+
+// a regex's NFA and its DFA
+struct CompiledAutomata
+{
+    NFA nfa;
+    DFA dfa;
+};
+
+// the whole pipeline: parse, DAG, Thompson, epsilon elimination, subset
+// construction (on pool when given) and minimization, timing each stage into
+// stats. the DFA is always built from the epsilon-free NFA, within the edge
+// budget. without stats or measurePeak it is safe to run from several threads
+CompiledAutomata compileRegex(const std::string& infix, const CompileOptions& options = CompileOptions(),
+                              PipelineStats* stats = nullptr, ThreadPool* pool = nullptr);
+
+// compileRegex's DFA with the default options
+DFA regexToDFA(const std::string& infix, bool minimize = true, MinimizeReport* report = nullptr,
+               PipelineStats* stats = nullptr, const CompileLimits& limits = CompileLimits());
 
 #endif
\ No newline at end of file
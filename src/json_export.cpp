@@ -0,0 +1,398 @@
+#include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include "json_export.hpp"
+#include "../include/AllocTracker.h"
+
+using namespace std;
+
+// Helper function to convert state numbers to q{state}
+string stateToString(int state) {
+    return "q" + to_string(state);
+}
+
+// Helper function to convert NFA to JSON
+json nfaToJson(const NFA& nfa) {
+    json result;
+    
+    // Get all states
+    set<int> allStates;
+    map<int, map<char, set<int>>> transitions = nfa.getNFATransitions();
+    
+    // Collect all states from transitions
+    for (const auto& row : transitions) {
+        allStates.insert(row.first);
+        for (const auto& trans : row.second) {
+            for (int state : trans.second) {
+                allStates.insert(state);
+            }
+        }
+    }
+    // Add initial and final states
+    allStates.insert(nfa.getInitState());
+    for (int state : nfa.getFinalStates()) {
+        allStates.insert(state);
+    }
+    
+    // Convert states to string array
+    vector<int> sortedStates(allStates.begin(), allStates.end());
+
+    vector<string> stateStrings;
+    for (int state : sortedStates) {
+        stateStrings.push_back(stateToString(state));
+    }
+    result["states"] = stateStrings;
+    
+    // Convert transitions
+    json transObj;
+    for (const auto& row : transitions) {
+        string srcState = stateToString(row.first);
+        json srcTrans;
+        for (const auto& trans : row.second) {
+            char sym = trans.first;
+            string symStr = (sym == '_') ? "ε" : string(1, sym);
+            if (trans.second.size() == 1) {
+                srcTrans[symStr] = stateToString(*trans.second.begin());
+            } else {
+                // Multiple destinations - represent as array
+                vector<string> dests;
+                for (int dest : trans.second) {
+                    dests.push_back(stateToString(dest));
+                }
+                srcTrans[symStr] = dests;
+            }
+        }
+        if (!srcTrans.empty()) {
+            transObj[srcState] = srcTrans;
+        }
+    }
+    result["transitions"] = transObj;
+    
+    // Start state
+    result["start"] = stateToString(nfa.getInitState());
+    
+    // Accept states
+    vector<string> acceptStates;
+    for (int state : nfa.getFinalStates()) {
+        acceptStates.push_back(stateToString(state));
+    }
+    result["accept"] = acceptStates;
+    
+    return result;
+}
+
+// Helper function to convert DFA to JSON
+json dfaToJson(const DFA& dfa) {
+    json result;
+    
+    // Get all states
+    set<int> allStates;
+    map<int, map<char, int>> transitions = dfa.getDFATransitions();
+    
+    // Collect all states from transitions
+    for (const auto& row : transitions) {
+        allStates.insert(row.first);
+        for (const auto& trans : row.second) {
+            allStates.insert(trans.second);
+        }
+    }
+    // Add initial and final states
+    set<int> initStates = dfa.getInitStates();
+    for (int state : initStates) {
+        allStates.insert(state);
+    }
+    set<int> finalStates = dfa.getFinalStates();
+    for (int state : finalStates) {
+        allStates.insert(state);
+    }
+
+    // Sort states for consistent mapping
+    vector<int> sortedStates(allStates.begin(), allStates.end());
+    
+    vector<string> stateStrings;
+    for (int state : sortedStates) {
+        stateStrings.push_back(stateToString(state));
+    }
+    result["states"] = stateStrings;
+    
+    // Convert transitions
+    json transObj;
+    for (const auto& row : transitions) {
+        string srcState = stateToString(row.first);
+        json srcTrans;
+        for (const auto& trans : row.second) {
+            char sym = trans.first;
+            string symStr = string(1, sym);
+            string dstState = stateToString(trans.second);
+            srcTrans[symStr] = dstState;
+        }
+        if (!srcTrans.empty()) {
+            transObj[srcState] = srcTrans;
+        }
+    }
+    result["transitions"] = transObj;
+    
+    // Start state
+    if (!initStates.empty()) {
+        result["start"] = stateToString(*initStates.begin());
+    } else {
+        result["start"] = "";
+    }
+    
+    // Accept states
+    vector<string> acceptStates;
+    for (int state : finalStates) {
+        acceptStates.push_back(stateToString(state));
+    }
+    result["accept"] = acceptStates;
+    
+    return result;
+}
+
+json statsToJson(const PipelineStats& stats) {
+    json result;
+    result["ms"] = {
+        {"parse", stats.parseMs},
+        {"thompson", stats.thompsonMs},
+        {"epsilon", stats.epsilonMs},
+        {"closure", stats.closureMs},
+        {"subset", stats.subsetMs},
+        {"minimize", stats.minimizeMs},
+        {"total", stats.totalMs},
+    };
+    result["nfa"] = {{"states", stats.nfaStates}, {"edges", stats.nfaEdges}};
+    result["epsilonFree"] = {{"states", stats.epsFreeStates}, {"edges", stats.epsFreeEdges}};
+    result["dfa"] = {{"states", stats.dfaStates}, {"edges", stats.dfaEdges}};
+    result["minimized"] = {{"states", stats.minDfaStates}, {"edges", stats.minDfaEdges}};
+    result["closureComputations"] = stats.closureComputations;
+    result["sharing"] = {
+        {"treeNodes", stats.sharing.treeNodes},
+        {"dagNodes", stats.sharing.dagNodes},
+        {"sharedNodes", stats.sharing.sharedNodes},
+        {"largestShared", stats.sharing.largestShared},
+        {"clonedStates", stats.clonedStates},
+    };
+    if (AllocTracker::Enabled()) {
+        result["peakBytes"] = stats.peakBytes;
+    }
+    return result;
+}
+
+// q{state} for PRETTY, the bare number for COMPACT, without allocating
+struct StateName {
+    char text[16];
+    size_t size;
+
+    StateName(int state, JsonStyle style) {
+        char* begin = text;
+        if (style == JsonStyle::PRETTY) {
+            *begin++ = 'q';
+        }
+        size = to_chars(begin, text + sizeof(text), state).ptr - text;
+    }
+    string_view view() const { return string_view(text, size); }
+};
+
+static void writeState(JsonWriter& writer, int state, JsonStyle style) {
+    if (style == JsonStyle::PRETTY) {
+        writer.String(StateName(state, style).view());
+    } else {
+        writer.Int(state);
+    }
+}
+
+// nlohmann::json sorts object keys as strings, so q10 comes before q2
+static void sortByName(vector<int>& states) {
+    sort(states.begin(), states.end(), [](int a, int b) {
+        char textA[12], textB[12];
+        char* endA = to_chars(textA, textA + sizeof(textA), a).ptr;
+        char* endB = to_chars(textB, textB + sizeof(textB), b).ptr;
+        return lexicographical_compare(textA, endA, textB, endB);
+    });
+}
+
+static void writeStateArray(JsonWriter& writer, const vector<bool>& present, JsonStyle style) {
+    writer.BeginArray();
+    for (size_t state = 0; state < present.size(); state++) {
+        if (present[state]) {
+            writeState(writer, state, style);
+        }
+    }
+    writer.EndArray();
+}
+
+// one symbol of an NFA state: its destinations as a set, a single one unwrapped
+static void writeNfaRun(JsonWriter& writer, const NFAEdge* run, const NFAEdge* end, JsonStyle style) {
+    writer.Key(run->sym == '_' ? string_view("ε") : string_view(&run->sym, 1));
+    if (all_of(run, end, [&](const NFAEdge& edge) { return edge.dst == run->dst; })) {
+        writeState(writer, run->dst, style);
+        return;
+    }
+    writer.BeginArray();
+    for (const NFAEdge* e = run; e != end; e++) {
+        if (e == run || e->dst != e[-1].dst) {
+            writeState(writer, e->dst, style);
+        }
+    }
+    writer.EndArray();
+}
+
+//---------------------------------------------------------------------------------
+// read the arena directly. its edges are sorted by (symbol, destination), so each
+// symbol's destinations are one run. ε sorts after every letter and goes last
+//---------------------------------------------------------------------------------
+void writeNfaJson(JsonWriter& writer, const NFA& nfa, JsonStyle style) {
+    const NFAArena& arena = nfa.getArena();
+    const set<int>& finals = nfa.getFinalStates();
+    int top = max(arena.NumStates() - 1, nfa.getInitState());
+    if (!finals.empty()) {
+        top = max(top, *finals.rbegin());
+    }
+
+    // states with edges, destinations, the start state and the final states
+    vector<bool> present(top + 1, false);
+    vector<int> rows;
+    for (int s = 0; s < arena.NumStates(); s++) {
+        if (arena.EdgesBegin(s) == arena.EdgesEnd(s)) {
+            continue;
+        }
+        present[s] = true;
+        rows.push_back(s);
+        for (const NFAEdge* e = arena.EdgesBegin(s); e != arena.EdgesEnd(s); e++) {
+            present[e->dst] = true;
+        }
+    }
+    present[nfa.getInitState()] = true;
+    for (int state : finals) {
+        present[state] = true;
+    }
+    sortByName(rows);
+
+    writer.BeginObject();
+    writer.Key("accept");
+    writer.BeginArray();
+    for (int state : finals) {
+        writeState(writer, state, style);
+    }
+    writer.EndArray();
+    writer.Key("start");
+    writeState(writer, nfa.getInitState(), style);
+    writer.Key("states");
+    writeStateArray(writer, present, style);
+
+    writer.Key("transitions");
+    writer.BeginObject();
+    for (int s : rows) {
+        writer.Key(StateName(s, style).view());
+        writer.BeginObject();
+        const NFAEdge* end = arena.EdgesEnd(s);
+        const NFAEdge* epsilonBegin = nullptr;
+        const NFAEdge* epsilonEnd = nullptr;
+        for (const NFAEdge* e = arena.EdgesBegin(s); e != end;) {
+            const NFAEdge* run = e;
+            while (e != end && e->sym == run->sym) {
+                e++;
+            }
+            if (run->sym == '_') {
+                epsilonBegin = run;
+                epsilonEnd = e;
+            } else {
+                writeNfaRun(writer, run, e, style);
+            }
+        }
+        if (epsilonBegin) {
+            writeNfaRun(writer, epsilonBegin, epsilonEnd, style);
+        }
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+}
+
+void writeDfaJson(JsonWriter& writer, const DFA& dfa, JsonStyle style) {
+    const map<int, map<char, int>>& transitions = dfa.getDFATransitions();
+    const set<int>& initStates = dfa.getInitStates();
+    const set<int>& finalStates = dfa.getFinalStates();
+
+    // states with transitions, destinations, the start states and the final states
+    int top = -1;
+    for (const auto& row : transitions) {
+        top = max(top, row.first);
+        for (const auto& trans : row.second) {
+            top = max(top, trans.second);
+        }
+    }
+    if (!initStates.empty()) {
+        top = max(top, *initStates.rbegin());
+    }
+    if (!finalStates.empty()) {
+        top = max(top, *finalStates.rbegin());
+    }
+    vector<bool> present(top + 1, false);
+    vector<int> rows;
+    vector<const map<char, int>*> rowOf(top + 1, nullptr);
+    for (const auto& row : transitions) {
+        present[row.first] = true;
+        if (row.second.empty()) {
+            continue;
+        }
+        rows.push_back(row.first);
+        rowOf[row.first] = &row.second;
+        for (const auto& trans : row.second) {
+            present[trans.second] = true;
+        }
+    }
+    for (int state : initStates) {
+        present[state] = true;
+    }
+    for (int state : finalStates) {
+        present[state] = true;
+    }
+    sortByName(rows);
+
+    writer.BeginObject();
+    writer.Key("accept");
+    writer.BeginArray();
+    for (int state : finalStates) {
+        writeState(writer, state, style);
+    }
+    writer.EndArray();
+    writer.Key("start");
+    if (!initStates.empty()) {
+        writeState(writer, *initStates.begin(), style);
+    } else {
+        writer.String("");
+    }
+    writer.Key("states");
+    writeStateArray(writer, present, style);
+
+    writer.Key("transitions");
+    writer.BeginObject();
+    for (int s : rows) {
+        writer.Key(StateName(s, style).view());
+        writer.BeginObject();
+        for (const auto& trans : *rowOf[s]) {
+            writer.Key(string_view(&trans.first, 1));
+            writeState(writer, trans.second, style);
+        }
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+}
+
+void writeAutomataJson(JsonWriter& writer, const NFA& nfa, const DFA& dfa, JsonStyle style,
+                       const PipelineStats* stats) {
+    writer.BeginObject();
+    writer.Key("dfa");
+    writeDfaJson(writer, dfa, style);
+    writer.Key("nfa");
+    writeNfaJson(writer, nfa, style);
+    if (stats) {
+        writer.Key("stats");
+        writer.Raw(statsToJson(*stats).dump(jsonIndent(style)));
+    }
+    writer.EndObject();
+}
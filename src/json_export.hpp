@@ -0,0 +1,36 @@
+#ifndef JSON_EXPORT_HPP
+#define JSON_EXPORT_HPP
+
+#include <string>
+#include <nlohmann/json.hpp>
+#include "../include/NFA.h"
+#include "../include/DFA.h"
+#include "../include/JsonWriter.h"
+#include "converter.hpp"
+
+using json = nlohmann::json;
+
+// q{state}, the state names used by resources/index.html
+std::string stateToString(int state);
+
+// {states, transitions, start, accept} as read by resources/index.html
+json nfaToJson(const NFA& nfa);
+json dfaToJson(const DFA& dfa);
+
+// per-stage timings and sizes of one compilation, ignored by resources/index.html
+json statsToJson(const PipelineStats& stats);
+
+// PRETTY: q{state} names indented by 2, byte for byte the dump(2) of the json
+// above. COMPACT: integer state ids without whitespace. index.html reads both
+enum class JsonStyle { PRETTY, COMPACT };
+inline int jsonIndent(JsonStyle style) { return style == JsonStyle::PRETTY ? 2 : -1; }
+
+// the objects nfaToJson and dfaToJson build, streamed straight from the
+// automaton into the writer, keys in the order nlohmann::json sorts them
+void writeNfaJson(JsonWriter& writer, const NFA& nfa, JsonStyle style);
+void writeDfaJson(JsonWriter& writer, const DFA& dfa, JsonStyle style);
+// {"dfa", "nfa"} and "stats" if given: a whole output.json
+void writeAutomataJson(JsonWriter& writer, const NFA& nfa, const DFA& dfa, JsonStyle style,
+                       const PipelineStats* stats = nullptr);
+
+#endif
@@ -7,165 +7,497 @@
 #include <algorithm>
 #include "../include/NFA.h"
 #include "../include/DFA.h"
+#include "../include/MultiPattern.h"
+#include "../include/StreamMatcher.h"
+#include "../include/ParallelMatcher.h"
+#include "../include/MappedFile.h"
+#include "../include/DFAFile.h"
 #include "converter.hpp"
-#include <nlohmann/json.hpp>
+#include "codegen.hpp"
+#include "json_export.hpp"
+#include "batch.hpp"
 #include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
 
-using json = nlohmann::json;
 using namespace std;
 
-// Helper function to convert state numbers to q{state}
-auto stateToString(int state) {
-    return "q" + to_string(state);
+// Helper function to read a whole file, false if it can't be opened
+bool readFile(const string& path, string& contents) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
 }
 
-// Helper function to convert NFA to JSON
-json nfaToJson(const NFA& nfa) {
-    json result;
-    
-    // Get all states
-    set<int> allStates;
-    map<int, map<char, set<int>>> transitions = nfa.getNFATransitions();
-    
-    // Collect all states from transitions
-    for (const auto& row : transitions) {
-        allStates.insert(row.first);
-        for (const auto& trans : row.second) {
-            for (int state : trans.second) {
-                allStates.insert(state);
-            }
+// Helper function to read one regex per line, whitespace stripped and blank lines skipped
+bool readPatterns(const string& path, vector<string>& patterns) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    string line;
+    while (getline(file, line)) {
+        line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+        if (!line.empty()) {
+            patterns.push_back(line);
         }
     }
-    // Add initial and final states
-    allStates.insert(nfa.getInitState());
-    for (int state : nfa.getFinalStates()) {
-        allStates.insert(state);
+    return true;
+}
+
+// --lex: compile every pattern into one DFA and tokenize the input file with it
+int runLexer(const string& patternsFile, const string& inputFile, const CompileLimits& limits) {
+    vector<string> patterns;
+    if (!readPatterns(patternsFile, patterns)) {
+        cerr << "Error: Could not open file " << patternsFile << endl;
+        return 1;
+    }
+    string text;
+    if (!readFile(inputFile, text)) {
+        cerr << "Error: Could not open file " << inputFile << endl;
+        return 1;
     }
-    
-    // Convert states to string array
-    vector<int> sortedStates(allStates.begin(), allStates.end());
 
-    vector<string> stateStrings;
-    for (int state : sortedStates) {
-        stateStrings.push_back(stateToString(state));
+    try {
+        MultiPattern lexer(patterns, limits);
+        size_t tokens = lexer.Scan(text, [&](int pattern, size_t begin, size_t end) {
+            cout << pattern << "\t" << begin << "\t" << end << "\t" << text.substr(begin, end - begin) << "\n";
+        });
+        cerr << tokens << " tokens, " << patterns.size() << " patterns, "
+             << lexer.getCompiled().NumStates() << " DFA states" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
     }
-    result["states"] = stateStrings;
-    
-    // Convert transitions
-    json transObj;
-    for (const auto& row : transitions) {
-        string srcState = stateToString(row.first);
-        json srcTrans;
-        for (const auto& trans : row.second) {
-            char sym = trans.first;
-            string symStr = (sym == '_') ? "ε" : string(1, sym);
-            if (trans.second.size() == 1) {
-                srcTrans[symStr] = stateToString(*trans.second.begin());
-            } else {
-                // Multiple destinations - represent as array
-                vector<string> dests;
-                for (int dest : trans.second) {
-                    dests.push_back(stateToString(dest));
-                }
-                srcTrans[symStr] = dests;
-            }
+    return 0;
+}
+
+// options shared by --scan and --load-binary
+struct ScanOptions {
+    size_t chunkSize = 1 << 20;
+    bool countOnly = false;
+    size_t maxMatch = StreamMatcher::DEFAULT_MAX_MATCH;
+    size_t threads = 1; // 0: one per core
+    CompileLimits limits; // for --scan's compile
+};
+
+// stream a memory-mapped data file through a compiled DFA in fixed-size chunks,
+// printing match offsets and throughput. with a pool the chunks are scanned
+// speculatively on it and stitched back together in order
+int scanFile(const CompiledDFA& table, const string& dataFile, const ScanOptions& options, ThreadPool* pool) {
+    MappedFile file(dataFile);
+    if (!file.IsOpen()) {
+        cerr << "Error: Could not open file " << dataFile << endl;
+        return 1;
+    }
+
+    auto print = [&](size_t begin, size_t end) {
+        if (!options.countOnly) {
+            cout << begin << "\t" << end << "\n";
         }
-        if (!srcTrans.empty()) {
-            transObj[srcState] = srcTrans;
+    };
+    StreamMatcher matcher(table, print, options.maxMatch);
+
+    auto start = chrono::steady_clock::now();
+    string_view data = file.Data();
+    size_t matches = 0;
+    if (pool) {
+        matches = ParallelMatcher(table, *pool, options.chunkSize).find_all(data, print, options.maxMatch);
+    } else {
+        for (size_t pos = 0; pos < data.size(); pos += options.chunkSize) {
+            matcher.Feed(data.substr(pos, options.chunkSize));
         }
+        matcher.Finish();
+        matches = matcher.Matches();
     }
-    result["transitions"] = transObj;
-    
-    // Start state
-    result["start"] = stateToString(nfa.getInitState());
-    
-    // Accept states
-    vector<string> acceptStates;
-    for (int state : nfa.getFinalStates()) {
-        acceptStates.push_back(stateToString(state));
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout.flush();
+    cerr << matches << " matches in " << data.size() << " bytes, "
+         << seconds << " s, " << (seconds > 0 ? data.size() / seconds / 1e6 : 0) << " MB/s" << endl;
+    if (matcher.Truncated()) {
+        cerr << matcher.Truncated() << " match attempts cut off at " << options.maxMatch
+             << " bytes, raise --max-match to follow them" << endl;
     }
-    result["accept"] = acceptStates;
-    
-    return result;
+    return 0;
 }
 
-// Helper function to convert DFA to JSON
-json dfaToJson(const DFA& dfa) {
-    json result;
-    
-    // Get all states
-    set<int> allStates;
-    map<int, map<char, int>> transitions = dfa.getDFATransitions();
-    
-    // Collect all states from transitions
-    for (const auto& row : transitions) {
-        allStates.insert(row.first);
-        for (const auto& trans : row.second) {
-            allStates.insert(trans.second);
+// the pool --threads asks for, if any
+unique_ptr<ThreadPool> makePool(size_t threads) {
+    if (threads == 1) {
+        return nullptr;
+    }
+    return make_unique<ThreadPool>(threads); // 0: one thread per core
+}
+
+// --scan: compile one regex and scan a data file with it, both on the pool
+int runScan(const string& regex, const string& dataFile, const ScanOptions& options) {
+    try {
+        unique_ptr<ThreadPool> pool = makePool(options.threads);
+        CompileOptions compile;
+        compile.limits = options.limits;
+        DFA dfa = move(compileRegex(regex, compile, nullptr, pool.get()).dfa);
+        return scanFile(dfa.getCompiled(), dataFile, options, pool.get());
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
+
+// --emit-binary: compile one regex and save its DFA in the binary format
+int runEmitBinary(const string& regex, const string& outputFile) {
+    try {
+        DFA dfa = regexToDFA(regex);
+        SaveDFA(dfa.getCompiled(), outputFile);
+        cout << dfa.getCompiled().NumStates() << " DFA states saved to " << outputFile << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// --emit-cpp: compile one regex and write it out as a self-contained C++ header
+int runEmitCpp(int argc, char* argv[]) {
+    string name = "generated_dfa";
+    CodegenStyle style = CodegenStyle::SWITCH;
+    vector<string> positional;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--style" && i + 1 < argc) {
+            string value = argv[++i];
+            if (value != "table" && value != "switch") {
+                cerr << "Error: --style must be table or switch" << endl;
+                return 1;
+            }
+            style = (value == "table") ? CodegenStyle::TABLE : CodegenStyle::SWITCH;
+        } else {
+            positional.push_back(arg);
         }
     }
-    // Add initial and final states
-    set<int> initStates = dfa.getInitStates();
-    for (int state : initStates) {
-        allStates.insert(state);
+    if (positional.size() != 2) {
+        cerr << "Usage: " << argv[0] << " --emit-cpp <regex> out.h [--name namespace] [--style table|switch]" << endl;
+        return 1;
     }
-    set<int> finalStates = dfa.getFinalStates();
-    for (int state : finalStates) {
-        allStates.insert(state);
+
+    try {
+        DFA dfa = regexToDFA(positional[0]);
+        string header = GenerateDFAHeader(dfa.getCompiled(), name, style, positional[0]);
+        ofstream out(positional[1]);
+        if (!out.is_open()) {
+            cerr << "Error: Could not create " << positional[1] << endl;
+            return 1;
+        }
+        out << header;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
     }
+    return 0;
+}
 
-    // Sort states for consistent mapping
-    vector<int> sortedStates(allStates.begin(), allStates.end());
-    
-    vector<string> stateStrings;
-    for (int state : sortedStates) {
-        stateStrings.push_back(stateToString(state));
+// --load-binary: map a saved DFA and scan a data file with it, no compilation
+int runLoadBinary(const string& dfaFile, const string& dataFile, const ScanOptions& options) {
+    try {
+        auto start = chrono::steady_clock::now();
+        // the file comes from the command line: check every transition once
+        // rather than trust it and index out of the table on a corrupt one
+        shared_ptr<const CompiledDFA> table = LoadDFA(dfaFile, true);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cerr << table->NumStates() << " DFA states loaded in " << seconds * 1e6 << " us" << endl;
+        return scanFile(*table, dataFile, options, makePool(options.threads).get());
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
     }
-    result["states"] = stateStrings;
-    
-    // Convert transitions
-    json transObj;
-    for (const auto& row : transitions) {
-        string srcState = stateToString(row.first);
-        json srcTrans;
-        for (const auto& trans : row.second) {
-            char sym = trans.first;
-            string symStr = string(1, sym);
-            string dstState = stateToString(trans.second);
-            srcTrans[symStr] = dstState;
-        }
-        if (!srcTrans.empty()) {
-            transObj[srcState] = srcTrans;
-        }
-    }
-    result["transitions"] = transObj;
-    
-    // Start state
-    if (!initStates.empty()) {
-        result["start"] = stateToString(*initStates.begin());
+}
+
+// --max-states, --max-memory and --max-ms, false if argv[i] is none of them
+bool parseLimitOption(int argc, char* argv[], int& i, CompileLimits& limits) {
+    string arg = argv[i];
+    if (arg == "--max-states" && i + 1 < argc) {
+        limits.max_states = strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--max-memory" && i + 1 < argc) {
+        limits.max_bytes = strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--max-ms" && i + 1 < argc) {
+        limits.max_ms = strtod(argv[++i], nullptr);
     } else {
-        result["start"] = "";
+        return false;
     }
-    
-    // Accept states
-    vector<string> acceptStates;
-    for (int state : finalStates) {
-        acceptStates.push_back(stateToString(state));
+    return true;
+}
+
+// --scan and --load-binary options, the rest are positional
+void parseScanOptions(int argc, char* argv[], ScanOptions& options, vector<string>& positional) {
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--chunk" && i + 1 < argc) {
+            options.chunkSize = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-match" && i + 1 < argc) {
+            options.maxMatch = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--count") {
+            options.countOnly = true;
+        } else if (!parseLimitOption(argc, argv, i, options.limits)) {
+            positional.push_back(arg);
+        }
     }
-    result["accept"] = acceptStates;
-    
-    return result;
+}
+
+// options shared by the default mode and --batch, false if argv[i] is none of them
+bool parseCompileOption(int argc, char* argv[], int& i, CompileOptions& options, JsonStyle& style, size_t& threads,
+                        bool& showStats) {
+    string arg = argv[i];
+    if (arg == "--no-minimize") {
+        options.minimize = false;
+    } else if (arg == "--stats") {
+        showStats = true;
+    } else if (arg == "--eps-free") {
+        options.epsilonFree = true;
+    } else if (arg == "--compact") {
+        style = JsonStyle::COMPACT;
+    } else if (parseLimitOption(argc, argv, i, options.limits)) {
+        return true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+        threads = strtoull(argv[++i], nullptr, 10);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// --batch input: every file of a directory holds one regex on its first line and
+// is named after the file; a pattern file holds one regex per line, named after the line
+bool readBatch(const string& path, vector<BatchPattern>& patterns) {
+    namespace fs = std::filesystem;
+    error_code error;
+    if (fs::is_directory(path, error)) {
+        vector<fs::path> files;
+        for (const fs::directory_entry& entry : fs::directory_iterator(path, error)) {
+            if (entry.is_regular_file()) {
+                files.push_back(entry.path());
+            }
+        }
+        if (error) {
+            return false;
+        }
+        sort(files.begin(), files.end());
+        set<string> names;
+        for (const fs::path& file : files) {
+            string regex;
+            ifstream in(file);
+            getline(in, regex);
+            regex.erase(std::remove_if(regex.begin(), regex.end(), ::isspace), regex.end());
+            // a.txt and a.re would both write a.json
+            string name = names.insert(file.stem().string()).second ? file.stem().string() : file.filename().string();
+            patterns.push_back({name, regex});
+        }
+        return true;
+    }
+
+    ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    string line;
+    for (size_t number = 1; getline(file, line); number++) {
+        line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+        if (!line.empty()) {
+            patterns.push_back({"line" + to_string(number), line});
+        }
+    }
+    return true;
+}
+
+// --batch: compile every pattern of a directory or pattern file on a thread pool.
+// each pattern gets outdir/<name>.json, or one entry in outdir/combined.json, and
+// outdir/report.json lists every pattern with its error or DFA size
+int runBatch(int argc, char* argv[]) {
+    CompileOptions options;
+    JsonStyle style = JsonStyle::PRETTY;
+    size_t threads = 0;
+    bool showStats = false;
+    bool combined = false;
+    vector<string> positional;
+    for (int i = 2; i < argc; i++) {
+        if (parseCompileOption(argc, argv, i, options, style, threads, showStats)) {
+            continue;
+        }
+        string arg = argv[i];
+        if (arg == "--combined") {
+            combined = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() != 2) {
+        cerr << "Usage: " << argv[0] << " --batch <dir|patterns.txt> outdir [--combined] [--threads n] [--stats]"
+             << " [--no-minimize] [--eps-free] [--compact] [--max-states n] [--max-memory bytes] [--max-ms ms]" << endl;
+        return 1;
+    }
+    namespace fs = std::filesystem;
+    vector<BatchPattern> patterns;
+    if (!readBatch(positional[0], patterns)) {
+        cerr << "Error: Could not read " << positional[0] << endl;
+        return 1;
+    }
+    fs::path outdir = positional[1];
+    error_code error;
+    fs::create_directories(outdir, error);
+    if (error) {
+        cerr << "Error: Could not create " << outdir.string() << ": " << error.message() << endl;
+        return 1;
+    }
+
+    auto writeFile = [&](const fs::path& path, const function<void(JsonWriter&)>& body) {
+        ofstream out(path, ios::binary);
+        if (!out.is_open()) {
+            throw runtime_error("could not create " + path.string());
+        }
+        JsonWriter writer(out, jsonIndent(style));
+        body(writer);
+        writer.Flush();
+        if (!out) {
+            throw runtime_error("could not write " + path.string());
+        }
+    };
+
+    // per-pattern files are streamed by the workers. for the combined file they
+    // serialize into memory and the entries are written in order at the end
+    ThreadPool pool(threads); // 0: one thread per core
+    vector<string> outputs(combined ? patterns.size() : 0);
+    auto start = chrono::steady_clock::now();
+    vector<BatchResult> results = compileBatch(patterns, pool, options,
+                                               [&](size_t i, const CompiledAutomata& automata, const PipelineStats& stats) {
+        auto body = [&](JsonWriter& writer) {
+            writeAutomataJson(writer, automata.nfa, automata.dfa, style, showStats ? &stats : nullptr);
+        };
+        if (combined) {
+            ostringstream text;
+            {
+                JsonWriter writer(text, jsonIndent(style));
+                body(writer);
+            }
+            outputs[i] = text.str();
+        } else {
+            writeFile(outdir / (patterns[i].name + ".json"), body);
+        }
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    json report = batchReportToJson(patterns, results);
+    try {
+        if (combined) {
+            writeFile(outdir / "combined.json", [&](JsonWriter& writer) {
+                writer.BeginObject();
+                for (size_t i = 0; i < patterns.size(); i++) {
+                    if (results[i].error.empty()) {
+                        writer.Key(patterns[i].name);
+                        writer.Raw(outputs[i]);
+                    }
+                }
+                writer.EndObject();
+            });
+        }
+        writeFile(outdir / "report.json", [&](JsonWriter& writer) { writer.Raw(report.dump(2)); });
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    size_t failed = report["failed"];
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (!results[i].error.empty()) {
+            cerr << patterns[i].name << ": " << results[i].error << endl;
+        }
+    }
+    cout << patterns.size() - failed << " of " << patterns.size() << " patterns compiled in " << seconds << " s on "
+         << pool.Size() << " threads. Report saved to " << (outdir / "report.json").string() << endl;
+    return failed ? 1 : 0;
 }
 
 int main(int argc, char* argv[]) {
     // Check command line arguments
-    if (argc != 2) {
-        cerr << "Usage: " << argv[0] << " ../inputs/input.txt" << endl;
+    if (argc >= 2 && string(argv[1]) == "--lex") {
+        CompileLimits limits;
+        vector<string> positional;
+        for (int i = 2; i < argc; i++) {
+            if (!parseLimitOption(argc, argv, i, limits)) {
+                positional.push_back(argv[i]);
+            }
+        }
+        if (positional.size() != 2) {
+            cerr << "Usage: " << argv[0] << " --lex patterns.txt input.txt [--max-states n] [--max-memory bytes] [--max-ms ms]"
+                 << endl;
+            return 1;
+        }
+        return runLexer(positional[0], positional[1], limits);
+    }
+    if (argc >= 2 && (string(argv[1]) == "--scan" || string(argv[1]) == "--load-binary")) {
+        bool load = string(argv[1]) == "--load-binary";
+        ScanOptions options;
+        vector<string> positional;
+        parseScanOptions(argc, argv, options, positional);
+        if (positional.size() != 2) {
+            cerr << "Usage: " << argv[0] << (load ? " --load-binary pattern.dfa" : " --scan <regex>")
+                 << " data.txt [--chunk bytes] [--threads n] [--max-match bytes] [--count]"
+                 << (load ? "" : " [--max-states n] [--max-memory bytes] [--max-ms ms]") << endl;
+            return 1;
+        }
+        return load ? runLoadBinary(positional[0], positional[1], options)
+                    : runScan(positional[0], positional[1], options);
+    }
+    if (argc >= 2 && string(argv[1]) == "--emit-binary") {
+        if (argc != 4) {
+            cerr << "Usage: " << argv[0] << " --emit-binary <regex> pattern.dfa" << endl;
+            return 1;
+        }
+        return runEmitBinary(argv[2], argv[3]);
+    }
+    if (argc >= 2 && string(argv[1]) == "--emit-cpp") {
+        return runEmitCpp(argc, argv);
+    }
+    if (argc >= 2 && string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+
+    CompileOptions options;
+    JsonStyle style = JsonStyle::PRETTY;
+    bool showStats = false;
+    size_t threads = 1;
+    string inputFile;
+    for (int i = 1; i < argc; i++) {
+        if (parseCompileOption(argc, argv, i, options, style, threads, showStats)) {
+            continue;
+        }
+        if (inputFile.empty()) {
+            inputFile = argv[i];
+        } else {
+            inputFile.clear();
+            break;
+        }
+    }
+    if (inputFile.empty()) {
+        cerr << "Usage: " << argv[0] << " [--no-minimize] [--eps-free] [--compact] [--stats] [--threads n] [--max-states n] [--max-memory bytes] [--max-ms ms]"
+             << " ../inputs/input.txt" << endl;
+        cerr << "       " << argv[0] << " --lex patterns.txt input.txt [--max-states n] [--max-memory bytes] [--max-ms ms]" << endl;
+        cerr << "       " << argv[0] << " --scan <regex> data.txt [--chunk bytes] [--threads n] [--max-match bytes] [--count]"
+             << " [--max-states n] [--max-memory bytes] [--max-ms ms]" << endl;
+        cerr << "       " << argv[0] << " --emit-binary <regex> pattern.dfa" << endl;
+        cerr << "       " << argv[0] << " --load-binary pattern.dfa data.txt [--chunk bytes] [--threads n] [--max-match bytes] [--count]" << endl;
+        cerr << "       " << argv[0] << " --emit-cpp <regex> out.h [--name namespace] [--style table|switch]" << endl;
+        cerr << "       " << argv[0] << " --batch <dir|patterns.txt> outdir [--combined] [--threads n] [compile options]" << endl;
         return 1;
     }
     
-    string inputFile = argv[1];
-    
     // Read regex from input file
     ifstream file(inputFile);
     if (!file.is_open()) {
@@ -186,30 +518,39 @@ int main(int argc, char* argv[]) {
     }
     
     try {
-        // convert regex to DFA
-        string postfix = InfixToPostfix(regex);
-        NFA nfa = PostfixToNFA(postfix);
-        DFA dfa = NFAtoDFA(nfa);
-        
-        // create JSON output
-        json output;
-        output["nfa"] = nfaToJson(nfa);
-        output["dfa"] = dfaToJson(dfa);
+        // convert regex to DFA, timing each stage
+        PipelineStats stats;
+        unique_ptr<ThreadPool> pool = makePool(threads);
+        CompiledAutomata automata = compileRegex(regex, options, &stats, pool.get());
+        if (options.minimize) {
+            cout << "DFA states: " << stats.dfaStates << " -> " << stats.minDfaStates
+                 << " after minimization" << endl;
+        }
+        if (showStats) {
+            cout << statsToJson(stats).dump(2) << endl;
+        }
         
         ofstream outFile;
         string outputPath = "resources/output.json";
-        outFile.open(outputPath);
+        outFile.open(outputPath, ios::binary);
         if (!outFile.is_open()) {
             outputPath = "../resources/output.json";
-            outFile.open(outputPath);
+            outFile.open(outputPath, ios::binary);
             if (!outFile.is_open()) {
                 cerr << "Error: Could not create output.json" << endl;
                 return 1;
             }
         }
-        outFile << output.dump(2);
+        // streamed straight from the automata, no json tree in between
+        JsonWriter writer(outFile, jsonIndent(style));
+        writeAutomataJson(writer, automata.nfa, automata.dfa, style, showStats ? &stats : nullptr);
+        writer.Flush();
+        if (!outFile) {
+            cerr << "Error: Could not write " << outputPath << endl;
+            return 1;
+        }
         cout << "Regex converted. Results saved to " << outputPath << endl;
-    } catch (exception e) {
+    } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
         return 1;
     }
@@ -0,0 +1,53 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// minimal checks for the ctest programs: a failed CHECK prints where and
+// why and the test keeps going, main returns TestResult()
+//---------------------------------------------------------------------------------
+inline int &TestFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                      \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(cond))                                                                     \
+        {                                                                                \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << endl;  \
+            TestFailures()++;                                                            \
+        }                                                                                \
+    } while (0)
+
+// context is streamed into the message, e.g. CHECK_EQ(a, b, "regex " << r)
+#define CHECK_EQ(a, b, context)                                                          \
+    do                                                                                   \
+    {                                                                                    \
+        auto checkA = (a);                                                               \
+        auto checkB = (b);                                                               \
+        if (!(checkA == checkB))                                                         \
+        {                                                                                \
+            ostringstream checkMessage;                                                  \
+            checkMessage << context;                                                     \
+            cerr << __FILE__ << ":" << __LINE__ << ": " #a " == " #b " failed: " << checkA \
+                 << " != " << checkB << " (" << checkMessage.str() << ")" << endl;       \
+            TestFailures()++;                                                            \
+        }                                                                                \
+    } while (0)
+
+inline int TestResult()
+{
+    if (TestFailures())
+        cerr << TestFailures() << " checks failed" << endl;
+    return TestFailures() ? 1 : 0;
+}
+
+#endif
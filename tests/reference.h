@@ -0,0 +1,184 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <utility>
+#include <cctype>
+#include "../include/MatchLoops.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// class ReferenceRegex
+// the slow, obviously right matcher the engines are checked against: the
+// regex as a tree, matched by computing every end position reachable from a
+// set of start positions. no automaton is involved
+//---------------------------------------------------------------------------------
+class ReferenceRegex
+{
+public:
+    explicit ReferenceRegex(const string &infix)
+    {
+        vector<int> stack;
+        for (char c : InfixToPostfix(infix))
+        {
+            if (isalpha((unsigned char)c))
+            {
+                nodes.push_back({c, -1, -1});
+            }
+            else if (c == '*')
+            {
+                int inner = stack.back();
+                stack.pop_back();
+                nodes.push_back({c, inner, -1});
+            }
+            else
+            {
+                int right = stack.back();
+                stack.pop_back();
+                int left = stack.back();
+                stack.pop_back();
+                nodes.push_back({c, left, right});
+            }
+            stack.push_back(nodes.size() - 1);
+        }
+        root = stack.back();
+    }
+
+    // end of the longest match starting at pos, or NO_MATCH
+    size_t Longest(string_view text, size_t pos) const
+    {
+        set<size_t> ends = Ends(root, text, {pos});
+        return ends.empty() ? NO_MATCH : *ends.rbegin();
+    }
+
+    bool Matches(string_view text) const { return Ends(root, text, {0}).count(text.size()) > 0; }
+
+    bool Search(string_view text, MatchSpan &match) const
+    {
+        for (size_t pos = 0; pos <= text.size(); pos++)
+        {
+            size_t end = Longest(text, pos);
+            if (end != NO_MATCH)
+            {
+                match = {pos, end};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the find_all contract: leftmost-longest, non-overlapping, one byte on after an empty match
+    vector<pair<size_t, size_t>> FindAll(string_view text) const
+    {
+        vector<pair<size_t, size_t>> found;
+        for (size_t pos = 0; pos <= text.size();)
+        {
+            size_t end = Longest(text, pos);
+            if (end == NO_MATCH)
+            {
+                pos++;
+                continue;
+            }
+            found.push_back({pos, end});
+            pos = end > pos ? end : pos + 1;
+        }
+        return found;
+    }
+
+private:
+    struct Node
+    {
+        char op;
+        int left;
+        int right;
+    };
+
+    set<size_t> Ends(int id, string_view text, const set<size_t> &starts) const
+    {
+        const Node &node = nodes[id];
+        set<size_t> ends;
+        if (isalpha((unsigned char)node.op))
+        {
+            for (size_t p : starts)
+                if (p < text.size() && text[p] == node.op)
+                    ends.insert(p + 1);
+        }
+        else if (node.op == '.')
+        {
+            ends = Ends(node.right, text, Ends(node.left, text, starts));
+        }
+        else if (node.op == '|')
+        {
+            ends = Ends(node.left, text, starts);
+            set<size_t> right = Ends(node.right, text, starts);
+            ends.insert(right.begin(), right.end());
+        }
+        else // '*'
+        {
+            ends = starts;
+            set<size_t> frontier = starts;
+            while (!frontier.empty())
+            {
+                set<size_t> next;
+                for (size_t p : Ends(node.left, text, frontier))
+                    if (ends.insert(p).second)
+                        next.insert(p);
+                frontier = next;
+            }
+        }
+        return ends;
+    }
+
+    vector<Node> nodes;
+    int root;
+};
+
+// a random infix regex over a, b and c with explicit parentheses
+inline string RandomRegex(mt19937 &rng, int depth)
+{
+    if (depth == 0 || rng() % 4 == 0)
+        return string(1, "abc"[rng() % 3]);
+    switch (rng() % 3)
+    {
+    case 0:
+        return "(" + RandomRegex(rng, depth - 1) + "|" + RandomRegex(rng, depth - 1) + ")";
+    case 1:
+        return "(" + RandomRegex(rng, depth - 1) + "." + RandomRegex(rng, depth - 1) + ")";
+    default:
+        return "(" + RandomRegex(rng, depth - 1) + ")*";
+    }
+}
+
+inline string RandomText(mt19937 &rng, size_t maxLength, const char *alphabet = "abc")
+{
+    size_t length = rng() % (maxLength + 1);
+    size_t letters = string_view(alphabet).size();
+    string text;
+    for (size_t i = 0; i < length; i++)
+        text += alphabet[rng() % letters];
+    return text;
+}
+
+// same start, accepting states and transitions on every byte
+inline bool SameTable(const CompiledDFA &a, const CompiledDFA &b)
+{
+    if (a.NumStates() != b.NumStates() || a.Start() != b.Start())
+        return false;
+    for (uint32_t s = 0; s < a.NumStates(); s++)
+    {
+        if (a.IsAccepting(s) != b.IsAccepting(s))
+            return false;
+        for (int c = 0; c < 256; c++)
+            if (a.Next(s, (char)c) != b.Next(s, (char)c))
+                return false;
+    }
+    return true;
+}
+
+#endif
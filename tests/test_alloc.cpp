@@ -0,0 +1,36 @@
+#include <string>
+#include "check.h"
+#include "../include/AllocTracker.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// the allocation tracker, linked into this test like into the benchmarks.
+// regexToDFA only measures its peak when asked for stats, so a compile
+// without them leaves the caller's peak alone
+//---------------------------------------------------------------------------------
+
+static void AllocateAndFree(size_t bytes)
+{
+    volatile char *block = new char[bytes];
+    block[bytes - 1] = 1;
+    delete[] block;
+}
+
+int main()
+{
+    CHECK(AllocTracker::Enabled());
+    const size_t BIG = 8 << 20;
+
+    AllocScope outer;
+    AllocateAndFree(BIG);
+    regexToDFA("(a|b)*.a.b.b");
+    CHECK(outer.PeakBytes() >= BIG);
+
+    PipelineStats stats;
+    regexToDFA("(a|b)*.a.b.b", true, nullptr, &stats);
+    CHECK(stats.peakBytes > 0);
+    CHECK(stats.peakBytes < BIG);
+    return TestResult();
+}
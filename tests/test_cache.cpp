@@ -0,0 +1,170 @@
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "check.h"
+#include "../include/RegexCache.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// RegexCache counts hits and misses per normalized key, evicts least recently
+// used entries over its budget, and compiles a key once however many threads
+// ask for it at the same time, failures included
+//---------------------------------------------------------------------------------
+
+// (a|b)*.a followed by n (a|b): its DFA needs 2^(n+1) states
+static string BlowUp(int n)
+{
+    string regex = "(a|b)*.a";
+    for (int i = 0; i < n; i++)
+        regex += ".(a|b)";
+    return regex;
+}
+
+static void HitsAndMisses()
+{
+    RegexCache cache;
+    shared_ptr<const Pattern> first = cache.Get("a.b");
+    CHECK(cache.Get("a.b") == first);
+    CHECK(cache.Get(" a . b\t") == first);
+    CHECK(cache.Get("a.c") != first);
+    RegexCacheStats stats = cache.Stats();
+    CHECK_EQ(stats.misses, 2u, "a.b and a.c");
+    CHECK_EQ(stats.hits, 2u, "a.b twice more");
+    CHECK_EQ(stats.entries, 2u, "entries");
+    CHECK_EQ(stats.evictions, 0u, "evictions");
+
+    cache.Clear();
+    stats = cache.Stats();
+    CHECK_EQ(stats.entries, 0u, "after Clear");
+    CHECK_EQ(stats.bytes, 0u, "after Clear");
+    CHECK_EQ(stats.misses, 2u, "Clear keeps the counters");
+    CHECK(cache.Get("a.b") != first);
+    CHECK_EQ(cache.Stats().misses, 3u, "a.b compiled again");
+}
+
+static void EvictsLeastRecentlyUsed()
+{
+    // a, b and c compile to the same table, so every entry costs the same
+    RegexCache probe;
+    probe.Get("a");
+    size_t entryBytes = probe.Stats().bytes;
+    CHECK(entryBytes > 0);
+
+    RegexCache cache(2 * entryBytes);
+    shared_ptr<const Pattern> a = cache.Get("a");
+    cache.Get("b");
+    cache.Get("c"); // over budget: a goes
+    CHECK_EQ(cache.Stats().evictions, 1u, "a evicted");
+    CHECK_EQ(cache.Stats().bytes, 2 * entryBytes, "two entries");
+    CHECK(a->matches("a")); // the caller's copy outlives the eviction
+
+    cache.Get("b"); // b is now the most recent, c the least
+    cache.Get("a"); // miss, c goes
+    RegexCacheStats stats = cache.Stats();
+    CHECK_EQ(stats.evictions, 2u, "c evicted");
+    CHECK_EQ(stats.misses, 4u, "a, b, c, a");
+    cache.Get("b");
+    CHECK_EQ(cache.Stats().hits, 2u, "b kept");
+
+    cache.SetBudget(entryBytes); // a is the least recent now
+    stats = cache.Stats();
+    CHECK_EQ(stats.entries, 1u, "one entry fits");
+    CHECK_EQ(stats.evictions, 3u, "a evicted by SetBudget");
+    cache.Get("b");
+    CHECK_EQ(cache.Stats().hits, 3u, "b kept");
+    CHECK_EQ(cache.Budget(), entryBytes, "budget");
+
+    cache.SetBudget(0);
+    CHECK_EQ(cache.Stats().entries, 0u, "nothing fits");
+}
+
+// full DFAs only, so BlowUp(14) takes a while and BlowUp(20) trips the limit
+static PatternOptions SlowOptions()
+{
+    PatternOptions options;
+    options.engine = MatchEngine::FULL_DFA;
+    options.lazyFallback = false;
+    options.limits.max_states = 1 << 17;
+    return options;
+}
+
+static void CoalescesConcurrentCompiles()
+{
+    const size_t threads = 8;
+    RegexCache cache(RegexCache::DEFAULT_BUDGET, SlowOptions());
+    vector<shared_ptr<const Pattern>> got(threads);
+    atomic<size_t> ready{0};
+    vector<thread> workers;
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back([&, i] {
+            ready++;
+            while (ready < threads)
+                this_thread::yield();
+            got[i] = cache.Get(BlowUp(14));
+        });
+    for (thread &worker : workers)
+        worker.join();
+
+    RegexCacheStats stats = cache.Stats();
+    CHECK_EQ(stats.misses, 1u, "one compile");
+    CHECK_EQ(stats.coalesced, threads - 1, "the others waited for it");
+    CHECK_EQ(stats.hits, 0u, "no thread came late");
+    CHECK(got[0] != nullptr);
+    for (size_t i = 1; i < threads; i++)
+        CHECK(got[i] == got[0]);
+}
+
+static void FailuresReachEveryWaiter()
+{
+    const size_t threads = 8;
+    RegexCache cache(RegexCache::DEFAULT_BUDGET, SlowOptions());
+    atomic<size_t> ready{0};
+    atomic<size_t> failed{0};
+    vector<thread> workers;
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back([&] {
+            ready++;
+            while (ready < threads)
+                this_thread::yield();
+            try
+            {
+                cache.Get(BlowUp(20));
+            }
+            catch (const DFALimitExceeded &)
+            {
+                failed++;
+            }
+        });
+    for (thread &worker : workers)
+        worker.join();
+
+    RegexCacheStats stats = cache.Stats();
+    CHECK_EQ(failed.load(), threads, "every thread sees the error");
+    CHECK_EQ(stats.misses + stats.coalesced, threads, "no hits on a failure");
+    CHECK_EQ(stats.entries, 0u, "nothing cached");
+    CHECK_EQ(stats.bytes, 0u, "nothing cached");
+
+    // not cached, so the next lookup compiles and fails again
+    bool thrown = false;
+    try
+    {
+        cache.Get("a|");
+    }
+    catch (const exception &)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK_EQ(cache.Stats().entries, 0u, "nothing cached");
+}
+
+int main()
+{
+    HitsAndMisses();
+    EvictsLeastRecentlyUsed();
+    CoalescesConcurrentCompiles();
+    FailuresReachEveryWaiter();
+    return TestResult();
+}
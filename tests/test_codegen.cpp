@@ -0,0 +1,66 @@
+#include <string>
+#include <stdexcept>
+#include "check.h"
+#include "reference.h"
+#include "../src/converter.hpp"
+#include "../src/codegen.hpp"
+#include "test_table.h"
+#include "test_switch.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// headers generated at build time by regex_generate_header, in both styles,
+// match what the interpreter they were generated from matches, and
+// GenerateDFAHeader rejects namespace names that would not compile
+//---------------------------------------------------------------------------------
+
+static_assert(test_table::match("bc") && !test_table::match("b"), "the table style is constexpr");
+
+static void AgainstInterpreter()
+{
+    DFA dfa = regexToDFA(TEST_CODEGEN_REGEX);
+    const CompiledDFA &table = dfa.getCompiled();
+    mt19937 rng(15);
+    for (int i = 0; i < 2000; i++)
+    {
+        // a byte outside the regex's alphabet now and then
+        string text = RandomText(rng, 16, "abcabcabcd");
+        bool expected = table.matches(text);
+        CHECK_EQ(test_table::match(text), expected, "table on " << text);
+        CHECK_EQ(test_switch::match(text), expected, "switch on " << text);
+        for (size_t pos = 0; pos <= text.size(); pos++)
+        {
+            size_t longest = table.LongestMatch(text, pos);
+            size_t end = longest == NO_MATCH ? string_view::npos : longest;
+            CHECK_EQ(test_table::longest_match(text, pos), end, "table on " << text << " at " << pos);
+            CHECK_EQ(test_switch::longest_match(text, pos), end, "switch on " << text << " at " << pos);
+        }
+    }
+}
+
+static void RejectsBadNames()
+{
+    DFA dfa = regexToDFA("a.b");
+    for (const char *name : {"", "1abc", "a-b", "a b", "a::b", "namespace", "int"})
+    {
+        bool thrown = false;
+        try
+        {
+            GenerateDFAHeader(dfa.getCompiled(), name, CodegenStyle::SWITCH);
+        }
+        catch (const invalid_argument &)
+        {
+            thrown = true;
+        }
+        CHECK_EQ(thrown, true, "name '" << name << "'");
+    }
+    CHECK(!GenerateDFAHeader(dfa.getCompiled(), "_ab_1", CodegenStyle::TABLE).empty());
+}
+
+int main()
+{
+    AgainstInterpreter();
+    RejectsBadNames();
+    return TestResult();
+}
@@ -0,0 +1,105 @@
+#include <string>
+#include <vector>
+#include "check.h"
+#include "reference.h"
+#include "../include/ThreadPool.h"
+#include "../src/converter.hpp"
+#include "../src/batch.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// compileRegex is the one pipeline: regexToDFA, the visualizer, --batch and
+// --scan get the same DFA from it, with its prefilter, and --eps-free only
+// changes the NFA returned
+//---------------------------------------------------------------------------------
+
+static void SameDFAEverywhere()
+{
+    ThreadPool pool(3);
+    mt19937 rng(11);
+    for (int i = 0; i < 100; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        DFA reference = regexToDFA(regex);
+        CompileOptions options;
+        CHECK(SameTable(compileRegex(regex, options).dfa.getCompiled(), reference.getCompiled()));
+        CHECK(SameTable(compileRegex(regex, options, nullptr, &pool).dfa.getCompiled(), reference.getCompiled()));
+        options.epsilonFree = true;
+        CHECK(SameTable(compileRegex(regex, options).dfa.getCompiled(), reference.getCompiled()));
+        options.minimize = false;
+        CHECK(SameTable(compileRegex(regex, options).dfa.getCompiled(), regexToDFA(regex, false).getCompiled()));
+    }
+}
+
+// the prefilter is in the table every way round, minimized or not
+static void CarriesPrefilter()
+{
+    ThreadPool pool(2);
+    mt19937 rng(24);
+    for (int i = 0; i < 100; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        Prefilter expected = Prefilter::FromPostfix(InfixToPostfix(regex));
+        for (bool minimize : {true, false})
+        {
+            CompileOptions options;
+            options.minimize = minimize;
+            for (ThreadPool *threads : {(ThreadPool *)nullptr, &pool})
+            {
+                DFA dfa = compileRegex(regex, options, nullptr, threads).dfa;
+                const Prefilter &prefilter = dfa.getCompiled().getPrefilter();
+                CHECK_EQ(prefilter.Enabled(), expected.Enabled(), regex << ", minimize " << minimize);
+                CHECK_EQ(prefilter.Literal(), expected.Literal(), regex << ", minimize " << minimize);
+                CHECK_EQ(prefilter.NumFirstBytes(), expected.NumFirstBytes(), regex << ", minimize " << minimize);
+            }
+        }
+    }
+}
+
+static void ReturnedNFA()
+{
+    CompileOptions options;
+    PipelineStats stats;
+    CompiledAutomata thompson = compileRegex("(a|b)*.c", options, &stats);
+    CHECK(thompson.nfa.HasEpsilons());
+    CHECK_EQ((size_t)thompson.nfa.NumStates(), stats.nfaStates, "Thompson NFA");
+    CHECK(stats.epsFreeStates > 0);
+    CHECK(stats.minDfaStates > 0 && stats.minDfaStates <= stats.dfaStates);
+
+    options.epsilonFree = true;
+    CompiledAutomata epsFree = compileRegex("(a|b)*.c", options, &stats);
+    CHECK(!epsFree.nfa.HasEpsilons());
+    CHECK_EQ((size_t)epsFree.nfa.NumStates(), stats.epsFreeStates, "epsilon-free NFA");
+}
+
+static void BatchUsesTheSamePipeline()
+{
+    ThreadPool pool(2);
+    vector<BatchPattern> patterns = {{"ab", "a.b"}, {"empty", ""}, {"bad", "a|"}, {"star", "(a|b)*.a"}};
+    vector<size_t> transitions(patterns.size());
+    vector<BatchResult> results = compileBatch(patterns, pool, CompileOptions(),
+                                               [&](size_t i, const CompiledAutomata &automata, const PipelineStats &) {
+                                                   transitions[i] = automata.dfa.NumTransitions();
+                                               });
+    CHECK(results[0].error.empty());
+    CHECK(!results[1].error.empty());
+    CHECK(!results[2].error.empty());
+    CHECK(results[3].error.empty());
+    for (size_t i : {0, 3})
+    {
+        DFA expected = regexToDFA(patterns[i].regex);
+        CHECK_EQ(transitions[i], expected.NumTransitions(), patterns[i].name);
+        CHECK_EQ(results[i].stats.minDfaStates, (size_t)expected.getCompiled().NumStates(), patterns[i].name);
+        CHECK_EQ(results[i].stats.peakBytes, 0u, "overlapping compiles measure no peak");
+    }
+}
+
+int main()
+{
+    SameDFAEverywhere();
+    CarriesPrefilter();
+    ReturnedNFA();
+    BatchUsesTheSamePipeline();
+    return TestResult();
+}
@@ -0,0 +1,73 @@
+#include <string>
+#include <string_view>
+#include "check.h"
+#include "reference.h"
+#include "../include/ConstexprRegex.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// compile_regex runs the whole pipeline during compilation (the static_asserts
+// would not compile otherwise) and its tables agree with the reference and
+// with the runtime DFA
+//---------------------------------------------------------------------------------
+
+constexpr auto abc = compile_regex("(a|b)*.c");
+static_assert(abc.matches("abac") && abc.matches("c") && !abc.matches("ab") && !abc.matches("abca"));
+static_assert(abc.LongestMatch("abcc") == 3 && abc.LongestMatch("ca", 1) == string_view::npos);
+static_assert(abc.NumStates() == 2, "(a|b)*.c minimizes to two states");
+
+constexpr auto anyStar = compile_regex("(a|b)*");
+static_assert(anyStar.matches("") && anyStar.matches("abba") && !anyStar.matches("abc"));
+
+constexpr auto longest = compile_regex("a|a.b");
+static_assert(longest.LongestMatch("abab") == 2);
+
+// evaluated at compile time, checked at run time
+constexpr StaticDFA<32> constants[] = {abc, anyStar, longest, compile_regex("(a.b)*.c*"), compile_regex("((a|b).c)*|a*")};
+constexpr const char *constantRegex[] = {"(a|b)*.c", "(a|b)*", "a|a.b", "(a.b)*.c*", "((a|b).c)*|a*"};
+
+template <size_t MaxStates>
+static void CompareWithReference(const StaticDFA<MaxStates> &dfa, const string &regex, mt19937 &rng)
+{
+    ReferenceRegex reference(regex);
+    DFA runtime = regexToDFA(regex);
+    CHECK_EQ(dfa.NumStates(), (size_t)runtime.getCompiled().NumStates(), "minimized size of " << regex);
+    for (int j = 0; j < 30; j++)
+    {
+        string text = RandomText(rng, 12);
+        CHECK_EQ(dfa.matches(text), reference.Matches(text), regex << " on " << text);
+        CHECK_EQ(dfa.matches(text), runtime.matches(text), "runtime " << regex << " on " << text);
+        for (size_t pos = 0; pos <= text.size(); pos++)
+        {
+            size_t expected = reference.Longest(text, pos);
+            size_t got = dfa.LongestMatch(text, pos);
+            CHECK_EQ(got == string_view::npos ? NO_MATCH : got, expected, regex << " on " << text << " at " << pos);
+        }
+    }
+}
+
+static void ConstantTables()
+{
+    mt19937 rng(16);
+    for (size_t i = 0; i < size(constants); i++)
+        CompareWithReference(constants[i], constantRegex[i], rng);
+}
+
+static void RandomRegexes()
+{
+    mt19937 rng(160);
+    for (int i = 0; i < 200; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        CompareWithReference(compile_regex<256>(regex), regex, rng);
+    }
+}
+
+int main()
+{
+    ConstantTables();
+    RandomRegexes();
+    return TestResult();
+}
@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+#include "check.h"
+#include "reference.h"
+#include "../include/RegexDAG.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// Thompson construction over the shared DAG builds the NFA PostfixToNFA
+// builds, state for state and edge for edge, and the sharing counters say
+// what was shared
+//---------------------------------------------------------------------------------
+
+// a regex made of a few random subexpressions, each used several times
+static string Repetitive(mt19937 &rng)
+{
+    vector<string> parts;
+    for (int i = 0; i < 3; i++)
+        parts.push_back("(" + RandomRegex(rng, 3) + ")");
+    string regex = parts[rng() % parts.size()];
+    for (int i = 0; i < 6; i++)
+    {
+        const string &part = parts[rng() % parts.size()];
+        switch (rng() % 3)
+        {
+        case 0: regex = "(" + regex + "|" + part + ")"; break;
+        case 1: regex = "(" + regex + "." + part + ")"; break;
+        default: regex = "(" + regex + "." + part + "*)"; break;
+        }
+    }
+    return regex;
+}
+
+static bool SameNFA(const NFA &a, const NFA &b)
+{
+    const NFAArena &x = a.getArena();
+    const NFAArena &y = b.getArena();
+    if (a.getInitState() != b.getInitState() || a.getFinalStates() != b.getFinalStates() ||
+        a.getAlpha() != b.getAlpha() || x.offsets != y.offsets || x.edges.size() != y.edges.size())
+        return false;
+    for (size_t i = 0; i < x.edges.size(); i++)
+        if (x.edges[i].dst != y.edges[i].dst || x.edges[i].sym != y.edges[i].sym)
+            return false;
+    return true;
+}
+
+static void SameAsPostfix()
+{
+    mt19937 rng(22);
+    size_t cloned = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        string regex = i % 2 ? Repetitive(rng) : RandomRegex(rng, 5);
+        string postfix = InfixToPostfix(regex);
+        RegexDAG dag = RegexDAG::FromPostfix(postfix);
+        PipelineStats stats;
+        NFA shared = DAGToNFA(dag, &stats);
+        CHECK_EQ(SameNFA(shared, PostfixToNFA(postfix)), true, regex);
+
+        RegexDAGStats sharing = dag.Stats();
+        CHECK_EQ(stats.sharing.treeNodes, postfix.size(), regex);
+        CHECK_EQ(stats.sharing.dagNodes, dag.NumNodes(), regex);
+        CHECK_EQ(stats.sharing.sharedNodes, sharing.sharedNodes, regex);
+        CHECK_EQ(stats.sharing.largestShared, sharing.largestShared, regex);
+        CHECK(sharing.dagNodes <= sharing.treeNodes);
+        CHECK_EQ(stats.clonedStates > 0, sharing.sharedNodes > 0, regex);
+        cloned += stats.clonedStates;
+    }
+    CHECK(cloned > 0);
+}
+
+static void Counters()
+{
+    // (a|b) three times: one shared operator of 3 tree nodes, built once and copied twice
+    PipelineStats stats;
+    DAGToNFA(RegexDAG::FromPostfix(InfixToPostfix("(a|b).(a|b).(a|b)")), &stats);
+    CHECK_EQ(stats.sharing.treeNodes, 11u, "3 * 3 + 2");
+    CHECK_EQ(stats.sharing.dagNodes, 5u, "a, b, |, and two different .");
+    CHECK_EQ(stats.sharing.sharedNodes, 1u, "|");
+    CHECK_EQ(stats.sharing.largestShared, 3u, "a|b");
+    CHECK_EQ(stats.clonedStates, 2 * (size_t)PostfixToNFA("ab|").NumStates(), "two copies of a|b");
+
+    // repeated symbols are nodes of their own but nothing to copy
+    PipelineStats plain;
+    DAGToNFA(RegexDAG::FromPostfix(InfixToPostfix("a.a.b")), &plain);
+    CHECK_EQ(plain.sharing.treeNodes, 5u, "a.a.b");
+    CHECK_EQ(plain.sharing.dagNodes, 4u, "a, b and two .");
+    CHECK_EQ(plain.sharing.sharedNodes, 0u, "no operator repeats");
+    CHECK_EQ(plain.clonedStates, 0u, "nothing copied");
+
+    // a shared operator inside a shared operator: the outer one is the largest
+    RegexDAGStats nested = RegexDAG::FromPostfix(InfixToPostfix("((a|b)*.c)|((a|b)*.c)")).Stats();
+    CHECK_EQ(nested.sharedNodes, 3u, "|, * and . inside");
+    CHECK_EQ(nested.largestShared, 6u, "(a|b)*.c");
+}
+
+int main()
+{
+    SameAsPostfix();
+    Counters();
+    return TestResult();
+}
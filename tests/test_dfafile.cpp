@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "check.h"
+#include "../include/DFAFile.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// SaveDFA / LoadDFA round trip, a corrupt transition caught by verify, and a
+// header whose table could not be indexed in 32 bits
+//---------------------------------------------------------------------------------
+
+// LoadDFA's error, empty if it loaded
+static string LoadError(const string &path, bool verify)
+{
+    try
+    {
+        LoadDFA(path, verify);
+    }
+    catch (const runtime_error &e)
+    {
+        return e.what();
+    }
+    return "";
+}
+
+static bool Throws(const string &path, bool verify)
+{
+    return !LoadError(path, verify).empty();
+}
+
+static void Patch(const string &path, size_t offset, uint32_t value)
+{
+    fstream file(path, ios::binary | ios::in | ios::out);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+int main()
+{
+    string path = (filesystem::temp_directory_path() / "test_dfafile.dfa").string();
+    DFA dfa = regexToDFA("(a|b)*.a.b.c");
+    SaveDFA(dfa.getCompiled(), path);
+    {
+        shared_ptr<const CompiledDFA> loaded = LoadDFA(path, true);
+        CHECK_EQ(loaded->NumStates(), dfa.getCompiled().NumStates(), "states");
+        CHECK(loaded->matches("ababc"));
+        CHECK(!loaded->matches("abcab"));
+        size_t count = loaded->find_all("xxabcabbabc", [](size_t, size_t) {});
+        CHECK_EQ(count, 2u, "find_all on the loaded DFA");
+    }
+
+    // point the first transition past the last state
+    DFAFileHeader header;
+    {
+        ifstream in(path, ios::binary);
+        in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    }
+    Patch(path, header.tableOffset, header.numStates + 5);
+    CHECK(Throws(path, true));
+    CHECK(!Throws(path, false)); // the bounds checks alone do not read the table
+
+    // 2^24 + 1 states of 256 classes: state * width wraps around in 32 bits
+    Patch(path, offsetof(DFAFileHeader, numStates), (1u << 24) + 1);
+    Patch(path, offsetof(DFAFileHeader, width), 256);
+    CHECK(LoadError(path, false).find("2^32 entries") != string::npos);
+
+    CHECK(Throws(path + ".missing", true));
+    remove(path.c_str());
+    return TestResult();
+}
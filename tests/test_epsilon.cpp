@@ -0,0 +1,151 @@
+#include <string>
+#include <set>
+#include <queue>
+#include <vector>
+#include "check.h"
+#include "reference.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// RemoveEpsilons leaves no epsilon edge, keeps the language, drops states
+// that are unreachable or cannot reach a final state, gives the NFA back
+// when the edge budget is exceeded, and the pipeline really runs it
+//---------------------------------------------------------------------------------
+
+// the NFA's language, by set simulation
+static bool Accepts(const NFA &nfa, string_view text)
+{
+    set<int> current = nfa.EpsilonClosure({nfa.getInitState()});
+    for (char c : text)
+        current = nfa.EpsilonClosure(nfa.move(current, c));
+    for (int state : current)
+        if (nfa.getFinalStates().count(state))
+            return true;
+    return false;
+}
+
+// every state is reachable from the start and reaches a final state
+static bool AllStatesLive(const NFA &nfa)
+{
+    const NFAArena &arena = nfa.getArena();
+    int n = nfa.NumStates();
+    vector<vector<int>> reverse(n);
+    for (int s = 0; s < n; s++)
+        for (const NFAEdge *e = arena.EdgesBegin(s); e != arena.EdgesEnd(s); e++)
+            reverse[e->dst].push_back(s);
+
+    vector<bool> reached(n), live(n);
+    queue<int> work;
+    work.push(nfa.getInitState());
+    reached[nfa.getInitState()] = true;
+    for (; !work.empty(); work.pop())
+        for (const NFAEdge *e = arena.EdgesBegin(work.front()); e != arena.EdgesEnd(work.front()); e++)
+            if (!reached[e->dst])
+            {
+                reached[e->dst] = true;
+                work.push(e->dst);
+            }
+    for (int state : nfa.getFinalStates())
+    {
+        live[state] = true;
+        work.push(state);
+    }
+    for (; !work.empty(); work.pop())
+        for (int src : reverse[work.front()])
+            if (!live[src])
+            {
+                live[src] = true;
+                work.push(src);
+            }
+    for (int s = 0; s < n; s++)
+        if (!reached[s] || !live[s])
+            return false;
+    return true;
+}
+
+static void AgainstReference()
+{
+    mt19937 rng(23);
+    for (int i = 0; i < 300; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        ReferenceRegex reference(regex);
+        NFA thompson = PostfixToNFA(InfixToPostfix(regex));
+        EpsilonReport report;
+        NFA epsFree = RemoveEpsilons(thompson, &report);
+        CHECK(report.removed);
+        CHECK(!epsFree.HasEpsilons());
+        CHECK(AllStatesLive(epsFree));
+        CHECK_EQ(report.statesAfter, (size_t)epsFree.NumStates(), regex);
+        CHECK_EQ(report.edgesAfter, epsFree.getArena().edges.size(), regex);
+        CHECK(report.statesAfter <= report.statesBefore);
+        for (int j = 0; j < 20; j++)
+        {
+            string text = RandomText(rng, 10);
+            CHECK_EQ(Accepts(epsFree, text), reference.Matches(text), regex << " on " << text);
+        }
+    }
+}
+
+static void DropsDeadStates()
+{
+    // 0 -a-> 1 (final), 0 -b-> 2 (a dead end), 3 -a-> 1 (unreachable)
+    NFA nfa({'a', 'b'}, 0, {1});
+    nfa.AddTransition(0, {1}, 'a');
+    nfa.AddTransition(0, {2}, 'b');
+    nfa.AddTransition(3, {1}, 'a');
+    NFA pruned = RemoveEpsilons(nfa);
+    CHECK_EQ(pruned.NumStates(), 2, "the start and 1");
+    CHECK_EQ(pruned.getArena().edges.size(), 1u, "only the a edge");
+    CHECK(Accepts(pruned, "a"));
+    CHECK(!Accepts(pruned, "b"));
+}
+
+static void KeepsThompsonOverBudget()
+{
+    // every a*.b*... state needs an edge to every later symbol: quadratic
+    string regex = "a*";
+    for (char c = 'b'; c <= 'z'; c++)
+        regex += string(".") + c + "*";
+    NFA thompson = PostfixToNFA(InfixToPostfix(regex));
+    EpsilonReport report;
+    NFA kept = RemoveEpsilons(thompson, &report, EpsilonEdgeBudget(thompson));
+    CHECK(!report.removed);
+    CHECK(kept.HasEpsilons());
+    CHECK_EQ(kept.NumStates(), thompson.NumStates(), "the input back");
+    CHECK_EQ(kept.getArena().edges.size(), thompson.getArena().edges.size(), "the input back");
+
+    EpsilonReport unbounded;
+    RemoveEpsilons(thompson, &unbounded);
+    CHECK(unbounded.removed);
+    CHECK(unbounded.edgesAfter > EpsilonEdgeBudget(thompson));
+}
+
+static void PipelineRunsIt()
+{
+    mt19937 rng(230);
+    for (int i = 0; i < 50; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        NFA thompson = PostfixToNFA(InfixToPostfix(regex));
+        EpsilonReport report;
+        RemoveEpsilons(thompson, &report, EpsilonEdgeBudget(thompson));
+
+        PipelineStats stats;
+        regexToDFA(regex, true, nullptr, &stats);
+        CHECK_EQ(stats.epsFreeStates, report.statesAfter, "regexToDFA " << regex);
+        CHECK_EQ(stats.epsFreeEdges, report.edgesAfter, "regexToDFA " << regex);
+        CHECK(stats.epsFreeStates > 0);
+    }
+}
+
+int main()
+{
+    AgainstReference();
+    DropsDeadStates();
+    KeepsThompsonOverBudget();
+    PipelineRunsIt();
+    return TestResult();
+}
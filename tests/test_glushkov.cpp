@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include "check.h"
+#include "reference.h"
+#include "../include/GlushkovNFA.h"
+#include "../include/Pattern.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// GlushkovNFA agrees with the reference, holds up to MAX_POSITIONS symbols,
+// and AUTO picks the full DFA, the bit-parallel NFA or the lazy DFA by size
+//---------------------------------------------------------------------------------
+
+static string Show(const vector<pair<size_t, size_t>> &spans)
+{
+    string text;
+    for (auto [begin, end] : spans)
+        text += "[" + to_string(begin) + "," + to_string(end) + ")";
+    return text;
+}
+
+// (a|b)*.a followed by n (a|b): its DFA needs 2^(n+1) states
+static string BlowUp(int n)
+{
+    string regex = "(a|b)*.a";
+    for (int i = 0; i < n; i++)
+        regex += ".(a|b)";
+    return regex;
+}
+
+static void AgainstReference()
+{
+    mt19937 rng(20);
+    PatternOptions options;
+    options.engine = MatchEngine::BIT_PARALLEL;
+    for (int i = 0; i < 300; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        ReferenceRegex reference(regex);
+        GlushkovNFA nfa(InfixToPostfix(regex));
+        Pattern pattern(regex, options);
+        CHECK(pattern.Engine() == MatchEngine::BIT_PARALLEL);
+        for (int j = 0; j < 20; j++)
+        {
+            string text = RandomText(rng, 12);
+            CHECK_EQ(nfa.matches(text), reference.Matches(text), regex << " on " << text);
+            CHECK_EQ(pattern.matches(text), reference.Matches(text), "Pattern " << regex << " on " << text);
+
+            MatchSpan got{}, expected{};
+            bool found = nfa.search(text, got);
+            CHECK_EQ(found, reference.Search(text, expected), "search " << regex << " on " << text);
+            if (found)
+                CHECK_EQ(Show({{got.begin, got.end}}), Show({{expected.begin, expected.end}}),
+                         "search " << regex << " on " << text);
+
+            vector<pair<size_t, size_t>> all;
+            size_t count = nfa.find_all(text, [&](size_t begin, size_t end) { all.push_back({begin, end}); });
+            CHECK_EQ(count, all.size(), "find_all count");
+            CHECK_EQ(Show(all), Show(reference.FindAll(text)), "find_all " << regex << " on " << text);
+        }
+    }
+}
+
+static void PositionLimit()
+{
+    string longest = "a";
+    for (size_t i = 1; i < GlushkovNFA::MAX_POSITIONS; i++)
+        longest += ".a";
+    string postfix = InfixToPostfix(longest);
+    CHECK_EQ(GlushkovNFA::CountPositions(postfix), GlushkovNFA::MAX_POSITIONS, "63 symbols");
+    GlushkovNFA nfa(postfix);
+    CHECK_EQ(nfa.NumPositions(), GlushkovNFA::MAX_POSITIONS, "63 symbols");
+    CHECK(nfa.matches(string(63, 'a')));
+    CHECK(!nfa.matches(string(62, 'a')));
+    CHECK(!nfa.matches(string(64, 'a')));
+
+    bool thrown = false;
+    try
+    {
+        GlushkovNFA tooLong(InfixToPostfix(longest + ".a"));
+    }
+    catch (const invalid_argument &)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+static void AutoPicksEngine()
+{
+    CHECK(Pattern("a.b").Engine() == MatchEngine::FULL_DFA);
+    CHECK(Pattern(BlowUp(4)).Engine() == MatchEngine::FULL_DFA);
+
+    // 2^13 DFA states, 27 symbols
+    Pattern bitParallel(BlowUp(12));
+    CHECK(bitParallel.Engine() == MatchEngine::BIT_PARALLEL);
+    CHECK(bitParallel.getGlushkovNFA() != nullptr);
+    CHECK(bitParallel.matches("ba" + string(12, 'b')));
+    CHECK(!bitParallel.matches("ab" + string(12, 'b')));
+
+    // 2^31 DFA states, 63 symbols: still bit-parallel, one more is not
+    CHECK(Pattern(BlowUp(30)).Engine() == MatchEngine::BIT_PARALLEL);
+    Pattern lazy(BlowUp(31));
+    CHECK(lazy.Engine() == MatchEngine::LAZY_DFA);
+    CHECK(lazy.matches("a" + string(31, 'b')));
+
+    // a raised autoMaxStates lets the full DFA through
+    PatternOptions options;
+    options.autoMaxStates = 1 << 14;
+    CHECK(Pattern(BlowUp(12), options).Engine() == MatchEngine::FULL_DFA);
+}
+
+int main()
+{
+    AgainstReference();
+    PositionLimit();
+    AutoPicksEngine();
+    return TestResult();
+}
@@ -0,0 +1,121 @@
+#include <string>
+#include <sstream>
+#include "check.h"
+#include "reference.h"
+#include "../src/converter.hpp"
+#include "../src/json_export.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// the streamed output.json is byte for byte the dump(2) of the json tree,
+// the compact one parses back to the same automata, and strings stay valid
+// JSON whatever bytes they hold
+//---------------------------------------------------------------------------------
+
+static string Written(const CompiledAutomata &automata, JsonStyle style)
+{
+    ostringstream out;
+    {
+        JsonWriter writer(out, jsonIndent(style));
+        writeAutomataJson(writer, automata.nfa, automata.dfa, style);
+    }
+    return out.str();
+}
+
+static string Quoted(string_view value, int indent)
+{
+    ostringstream out;
+    {
+        JsonWriter writer(out, indent);
+        writer.String(value);
+    }
+    return out.str();
+}
+
+// (a|b)*.a followed by n (a|b): 2^(n+1) DFA states, output far past the writer's buffer
+static string BlowUp(int n)
+{
+    string regex = "(a|b)*.a";
+    for (int i = 0; i < n; i++)
+        regex += ".(a|b)";
+    return regex;
+}
+
+static void CheckAutomata(const string &regex, bool epsilonFree)
+{
+    CompileOptions options;
+    options.epsilonFree = epsilonFree;
+    CompiledAutomata automata = compileRegex(regex, options);
+    json tree = {{"dfa", dfaToJson(automata.dfa)}, {"nfa", nfaToJson(automata.nfa)}};
+
+    string pretty = Written(automata, JsonStyle::PRETTY);
+    CHECK_EQ(pretty == tree.dump(2), true, "pretty " << regex << ", eps-free " << epsilonFree);
+
+    json compact = json::parse(Written(automata, JsonStyle::COMPACT));
+    for (const char *automaton : {"dfa", "nfa"})
+    {
+        CHECK_EQ(compact[automaton]["states"].size(), tree[automaton]["states"].size(), automaton << " " << regex);
+        CHECK_EQ(compact[automaton]["accept"].size(), tree[automaton]["accept"].size(), automaton << " " << regex);
+        CHECK_EQ(compact[automaton]["transitions"].size(), tree[automaton]["transitions"].size(),
+                 automaton << " " << regex);
+        CHECK_EQ("q" + to_string(compact[automaton]["start"].get<int>()), tree[automaton]["start"].get<string>(),
+                 automaton << " " << regex);
+    }
+}
+
+static void SameAsDump()
+{
+    mt19937 rng(25);
+    for (int i = 0; i < 100; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        CheckAutomata(regex, false);
+        CheckAutomata(regex, true);
+    }
+    CheckAutomata(BlowUp(10), false);
+}
+
+static void Strings()
+{
+    // what dump accepts is written the same way
+    for (string value : {string(""), string("ab\"c\\d"), string("\n\t\r\b\f\x01\x1f"), string("\xc3\xa9\xe2\x82\xac"),
+                         string("\xf0\x9f\x98\x80 ok")})
+    {
+        CHECK_EQ(Quoted(value, -1), json(value).dump(), "string " << value);
+        CHECK_EQ(json::parse(Quoted(value, 2)).get<string>(), value, "round trip " << value);
+    }
+
+    // bytes that are not UTF-8, where dump throws, are their Latin-1 reading
+    CHECK_EQ(Quoted("a\xff", -1), string("\"a\\u00ff\""), "lone 0xff");
+    CHECK_EQ(Quoted("\xc3", -1), string("\"\\u00c3\""), "truncated sequence");
+    CHECK_EQ(Quoted("\xc0\xaf", -1), string("\"\\u00c0\\u00af\""), "overlong /");
+    CHECK_EQ(Quoted("\xed\xa0\x80", -1), string("\"\\u00ed\\u00a0\\u0080\""), "surrogate");
+    CHECK_EQ(Quoted("\xf4\x90\x80\x80", -1), string("\"\\u00f4\\u0090\\u0080\\u0080\""), "past U+10FFFF");
+    mt19937 rng(250);
+    for (int i = 0; i < 1000; i++)
+    {
+        string bytes;
+        for (size_t n = rng() % 8; bytes.size() < n;)
+            bytes += char(rng());
+        string quoted = Quoted(bytes, -1);
+        CHECK(json::accept(quoted));
+        string dumped;
+        try
+        {
+            dumped = json(bytes).dump();
+        }
+        catch (const json::exception &)
+        {
+            continue; // not UTF-8
+        }
+        CHECK_EQ(quoted, dumped, "valid UTF-8");
+    }
+}
+
+int main()
+{
+    SameAsDump();
+    Strings();
+    return TestResult();
+}
@@ -0,0 +1,66 @@
+#include <string>
+#include "check.h"
+#include "reference.h"
+#include "../include/LazyDFA.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// LazyDFA agrees with the reference however small its cache is, in both
+// full-cache modes, and its memory does not grow with the square of the NFA
+//---------------------------------------------------------------------------------
+
+static void AgainstReference()
+{
+    mt19937 rng(7);
+    for (int i = 0; i < 200; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        ReferenceRegex reference(regex);
+        NFA nfa = PostfixToNFA(InfixToPostfix(regex));
+        for (size_t maxStates : {2, 3, 64})
+        {
+            for (bool fallback : {false, true})
+            {
+                LazyDFAOptions options;
+                options.max_states = maxStates;
+                options.fallback_to_nfa = fallback;
+                LazyDFA lazy(nfa, options);
+                for (int j = 0; j < 10; j++)
+                {
+                    string text = RandomText(rng, 16);
+                    CHECK_EQ(lazy.matches(text), reference.Matches(text),
+                             regex << " on " << text << ", cache " << maxStates << ", fallback " << fallback);
+                    size_t count = lazy.find_all(text, [](size_t, size_t) {});
+                    CHECK_EQ(count, reference.FindAll(text).size(),
+                             "find_all " << regex << " on " << text << ", cache " << maxStates);
+                    CHECK(lazy.CachedStates() <= maxStates);
+                }
+            }
+        }
+    }
+}
+
+static void MemoryIsLinear()
+{
+    // 20000 symbols, 40000 NFA states: a closure table would take 200 MB
+    string regex = "a";
+    for (int i = 1; i < 20000; i++)
+        regex += ".a";
+    NFA nfa = PostfixToNFA(InfixToPostfix(regex));
+    LazyDFAOptions options;
+    options.max_states = 16;
+    LazyDFA lazy(nfa, options);
+    CHECK(lazy.MemoryBytes() < (8u << 20));
+    CHECK(lazy.matches(string(20000, 'a')));
+    CHECK(!lazy.matches(string(19999, 'a')));
+    CHECK(lazy.MemoryBytes() < (8u << 20));
+}
+
+int main()
+{
+    AgainstReference();
+    MemoryIsLinear();
+    return TestResult();
+}
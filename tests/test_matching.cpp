@@ -0,0 +1,93 @@
+#include <vector>
+#include <utility>
+#include "check.h"
+#include "reference.h"
+#include "../include/DFA.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// DFA::matches, search and find_all: whole-buffer, leftmost-longest,
+// non-overlapping, and one byte on after an empty match
+//---------------------------------------------------------------------------------
+
+static vector<pair<size_t, size_t>> FindAll(const DFA &dfa, string_view text)
+{
+    vector<pair<size_t, size_t>> found;
+    size_t count = dfa.find_all(text, [&](size_t begin, size_t end) { found.push_back({begin, end}); });
+    CHECK_EQ(count, found.size(), "find_all count");
+    return found;
+}
+
+static string Show(const vector<pair<size_t, size_t>> &spans)
+{
+    string text;
+    for (auto [begin, end] : spans)
+        text += "[" + to_string(begin) + "," + to_string(end) + ")";
+    return text;
+}
+
+static void FixedCases()
+{
+    DFA ab = regexToDFA("a.b");
+    CHECK(ab.matches("ab"));
+    CHECK(!ab.matches("abc"));
+    CHECK(!ab.matches("a"));
+    CHECK(!ab.matches(""));
+
+    CHECK(regexToDFA("(a|b)*").matches(""));
+
+    MatchSpan span{};
+    CHECK(ab.search("ccabcc", span));
+    CHECK_EQ(span.begin, 2u, "search begin");
+    CHECK_EQ(span.end, 4u, "search end");
+    CHECK(!ab.search("ba", span));
+
+    // leftmost first, then longest
+    DFA longest = regexToDFA("a|a.b");
+    CHECK(longest.search("cab", span));
+    CHECK_EQ(span.begin, 1u, "leftmost");
+    CHECK_EQ(span.end, 3u, "longest");
+
+    // empty matches are reported and the scan steps over them
+    CHECK_EQ(Show(FindAll(regexToDFA("a*"), "baab")), string("[0,0)[1,3)[3,3)[4,4)"), "a* on baab");
+    CHECK_EQ(Show(FindAll(ab, "abab.ab")), string("[0,2)[2,4)[5,7)"), "a.b non-overlapping");
+    CHECK_EQ(FindAll(ab, "").size(), 0u, "empty text");
+
+    // bytes outside the alphabet kill the DFA instead of being skipped
+    CHECK(!regexToDFA("a.b").matches("a\xff" "b"));
+}
+
+static void AgainstReference()
+{
+    mt19937 rng(2);
+    for (int i = 0; i < 300; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        ReferenceRegex reference(regex);
+        DFA dfa = regexToDFA(regex);
+        DFA raw = regexToDFA(regex, false);
+        for (int j = 0; j < 20; j++)
+        {
+            string text = RandomText(rng, 12);
+            CHECK_EQ(dfa.matches(text), reference.Matches(text), regex << " on " << text);
+            CHECK_EQ(raw.matches(text), reference.Matches(text), "unminimized " << regex << " on " << text);
+
+            MatchSpan got{}, expected{};
+            bool found = dfa.search(text, got);
+            CHECK_EQ(found, reference.Search(text, expected), "search " << regex << " on " << text);
+            if (found)
+                CHECK_EQ(Show({{got.begin, got.end}}), Show({{expected.begin, expected.end}}),
+                         "search " << regex << " on " << text);
+            CHECK_EQ(Show(FindAll(dfa, text)), Show(reference.FindAll(text)), "find_all " << regex << " on " << text);
+        }
+    }
+}
+
+int main()
+{
+    FixedCases();
+    AgainstReference();
+    return TestResult();
+}
@@ -0,0 +1,128 @@
+#include <string>
+#include <vector>
+#include <tuple>
+#include "check.h"
+#include "reference.h"
+#include "../include/MultiPattern.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// MultiPattern takes the longest match over all patterns and, among the
+// patterns that match it, the lowest index. Scan tokenizes with it
+//---------------------------------------------------------------------------------
+
+typedef vector<tuple<int, size_t, size_t>> Tokens;
+
+static Tokens Scan(const MultiPattern &lexer, string_view text)
+{
+    Tokens tokens;
+    size_t count = lexer.Scan(text, [&](int pattern, size_t begin, size_t end) { tokens.push_back({pattern, begin, end}); });
+    CHECK_EQ(count, tokens.size(), "Scan count");
+    return tokens;
+}
+
+static string Show(const Tokens &tokens)
+{
+    string text;
+    for (auto [pattern, begin, end] : tokens)
+        text += to_string(pattern) + "[" + to_string(begin) + "," + to_string(end) + ")";
+    return text;
+}
+
+// the longest end over all patterns at pos, and the first pattern reaching it
+static size_t ReferenceLongest(const vector<ReferenceRegex> &references, string_view text, size_t pos, int &pattern)
+{
+    size_t longest = NO_MATCH;
+    pattern = -1;
+    for (size_t i = 0; i < references.size(); i++)
+    {
+        size_t end = references[i].Longest(text, pos);
+        if (end != NO_MATCH && (longest == NO_MATCH || end > longest))
+        {
+            longest = end;
+            pattern = i;
+        }
+    }
+    return longest;
+}
+
+static void FixedCases()
+{
+    MultiPattern lexer({"a.b", "a*", "b"});
+    int pattern;
+    CHECK_EQ(lexer.LongestMatch("abaab", 0, pattern), 2u, "a.b beats a*");
+    CHECK_EQ(pattern, 0, "a.b");
+    CHECK_EQ(lexer.LongestMatch("abaab", 2, pattern), 4u, "a* beats nothing longer");
+    CHECK_EQ(pattern, 1, "a*");
+    CHECK_EQ(lexer.LongestMatch("abaab", 4, pattern), 5u, "b beats the empty a*");
+    CHECK_EQ(pattern, 2, "b");
+    CHECK_EQ(lexer.LongestMatch("c", 0, pattern), 0u, "a* matches empty");
+    CHECK_EQ(pattern, 1, "a*");
+    CHECK_EQ(Show(Scan(lexer, "abaabcb")), string("0[0,2)1[2,4)2[4,5)2[6,7)"), "tokens, c skipped");
+
+    // equal length: the lowest index wins, whichever way round
+    MultiPattern first({"b", "a*.b"});
+    CHECK_EQ(first.LongestMatch("b", 0, pattern), 1u, "b");
+    CHECK_EQ(pattern, 0, "b listed first");
+    MultiPattern second({"a*.b", "b"});
+    CHECK_EQ(second.LongestMatch("b", 0, pattern), 1u, "b");
+    CHECK_EQ(pattern, 0, "a*.b listed first");
+    MultiPattern same({"a.b", "a.b|c", "(a|b).b"});
+    CHECK_EQ(Show(Scan(same, "abbbcab")), string("0[0,2)2[2,4)1[4,5)0[5,7)"), "priority per token");
+
+    MultiPattern none({});
+    CHECK_EQ(none.NumPatterns(), 0u, "no patterns");
+    CHECK_EQ(none.LongestMatch("ab", 0, pattern), NO_MATCH, "nothing matches");
+    CHECK_EQ(pattern, -1, "no pattern");
+    CHECK_EQ(Scan(none, "abc").size(), 0u, "no tokens");
+}
+
+static void AgainstReference()
+{
+    mt19937 rng(8);
+    for (int i = 0; i < 200; i++)
+    {
+        vector<string> patterns;
+        vector<ReferenceRegex> references;
+        for (size_t n = 1 + rng() % 4; patterns.size() < n;)
+        {
+            patterns.push_back(RandomRegex(rng, 3));
+            references.emplace_back(patterns.back());
+        }
+        MultiPattern lexer(patterns);
+        for (int j = 0; j < 10; j++)
+        {
+            string text = RandomText(rng, 12);
+            Tokens expected;
+            for (size_t pos = 0; pos <= text.size(); pos++)
+            {
+                int pattern, expectedPattern;
+                size_t end = lexer.LongestMatch(text, pos, pattern);
+                size_t expectedEnd = ReferenceLongest(references, text, pos, expectedPattern);
+                CHECK_EQ(end, expectedEnd, "pattern " << i << " on " << text << " at " << pos);
+                CHECK_EQ(pattern, expectedPattern, "pattern " << i << " on " << text << " at " << pos);
+            }
+            for (size_t pos = 0; pos < text.size();)
+            {
+                int pattern;
+                size_t end = ReferenceLongest(references, text, pos, pattern);
+                if (end == NO_MATCH || end == pos)
+                {
+                    pos++;
+                    continue;
+                }
+                expected.push_back({pattern, pos, end});
+                pos = end;
+            }
+            CHECK_EQ(Show(Scan(lexer, text)), Show(expected), "Scan, pattern set " << i << " on " << text);
+        }
+    }
+}
+
+int main()
+{
+    FixedCases();
+    AgainstReference();
+    return TestResult();
+}
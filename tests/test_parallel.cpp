@@ -0,0 +1,93 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include "check.h"
+#include "reference.h"
+#include "../include/ParallelMatcher.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// ParallelMatcher agrees with the sequential engines for chunks as small as
+// one byte, where matches cross many chunk boundaries, and stays linear when
+// the real scan resumes inside a long speculative match
+//---------------------------------------------------------------------------------
+
+static vector<pair<size_t, size_t>> FindAll(const ParallelMatcher &matcher, string_view text)
+{
+    vector<pair<size_t, size_t>> found;
+    size_t count = matcher.find_all(text, [&](size_t begin, size_t end) { found.push_back({begin, end}); });
+    CHECK_EQ(count, found.size(), "find_all count");
+    return found;
+}
+
+static void AgainstReference()
+{
+    ThreadPool pool(3);
+    mt19937 rng(10);
+    for (int i = 0; i < 200; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        ReferenceRegex reference(regex);
+        DFA dfa = regexToDFA(regex);
+        for (size_t chunk : {1, 2, 5})
+        {
+            ParallelMatcher matcher(dfa.getCompiled(), pool, chunk);
+            for (int j = 0; j < 5; j++)
+            {
+                string text = RandomText(rng, 30);
+                CHECK_EQ(matcher.matches(text), reference.Matches(text), regex << " on " << text);
+                CHECK(FindAll(matcher, text) == reference.FindAll(text));
+            }
+        }
+    }
+}
+
+static void AgainstFindAll()
+{
+    // longer texts than the reference can take, against the whole-buffer find_all
+    ThreadPool pool(4);
+    mt19937 rng(11);
+    for (int i = 0; i < 300; i++)
+    {
+        string regex = RandomRegex(rng, 5);
+        DFA dfa = regexToDFA(regex);
+        ParallelMatcher matcher(dfa.getCompiled(), pool, 1 + rng() % 40);
+        string text = RandomText(rng, 2000, "ab");
+        vector<pair<size_t, size_t>> expected;
+        dfa.getCompiled().find_all(text, [&](size_t begin, size_t end) { expected.push_back({begin, end}); });
+        CHECK(FindAll(matcher, text) == expected);
+    }
+}
+
+static void LongSpeculativeMatch()
+{
+    // the real scan matches "e.d" and resumes inside the speculative match
+    // "d.a*.c" of the next chunk. from there every a starts an a*.b attempt
+    // that lives to the 'c', so probing each offset on its own was quadratic
+    DFA dfa = regexToDFA("e.d|d.a*.c|a*.b");
+    ThreadPool pool(2);
+    const size_t chunk = 1 << 16;
+    ParallelMatcher matcher(dfa.getCompiled(), pool, chunk);
+    string text = string(chunk - 1, 'f') + "ed" + string(1 << 19, 'a') + "c";
+
+    auto start = chrono::steady_clock::now();
+    vector<pair<size_t, size_t>> found = FindAll(matcher, text);
+    CHECK(chrono::duration<double>(chrono::steady_clock::now() - start).count() < 5);
+    CHECK(found == (vector<pair<size_t, size_t>>{{chunk - 1, chunk + 1}}));
+
+    // the same with a match the real scan does find inside the speculative one
+    text.back() = 'b';
+    found = FindAll(matcher, text);
+    CHECK(found == (vector<pair<size_t, size_t>>{{chunk - 1, chunk + 1}, {chunk + 1, text.size()}}));
+}
+
+int main()
+{
+    AgainstReference();
+    AgainstFindAll();
+    LongSpeculativeMatch();
+    return TestResult();
+}
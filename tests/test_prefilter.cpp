@@ -0,0 +1,137 @@
+#include <string>
+#include <vector>
+#include "check.h"
+#include "reference.h"
+#include "../include/Prefilter.h"
+#include "../include/RegexDAG.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// Prefilter::FromDAG finds the required literal and the first bytes, gives
+// up on nullable patterns, and every scan kernel this CPU runs finds the
+// same candidates, tails shorter than a vector included
+//---------------------------------------------------------------------------------
+
+static Prefilter FromRegex(const string &regex)
+{
+    return Prefilter::FromDAG(RegexDAG::FromPostfix(InfixToPostfix(regex)));
+}
+
+static string FirstBytes(const Prefilter &prefilter)
+{
+    string bytes;
+    for (int c = 0; c < 256; c++)
+        if (prefilter.IsFirstByte(c))
+            bytes += char(c);
+    return bytes;
+}
+
+static void Analysis()
+{
+    Prefilter abc = FromRegex("a.b.c");
+    CHECK(abc.Enabled());
+    CHECK_EQ(abc.Literal(), string("abc"), "a.b.c");
+    CHECK_EQ(FirstBytes(abc), string("a"), "a.b.c");
+
+    Prefilter common = FromRegex("(a.b.c)|(a.b.d)");
+    CHECK_EQ(common.Literal(), string("ab"), "common prefix");
+    Prefilter starred = FromRegex("a.b.(c|d)*.e");
+    CHECK_EQ(starred.Literal(), string("ab"), "literal ends at the star");
+    CHECK_EQ(FromRegex("a.b*.c").Literal(), string(""), "one byte is no literal");
+
+    Prefilter either = FromRegex("(a|b).c");
+    CHECK(either.Enabled());
+    CHECK_EQ(either.Literal(), string(""), "(a|b).c");
+    CHECK_EQ(FirstBytes(either), string("ab"), "(a|b).c");
+    CHECK_EQ(either.NumFirstBytes(), 2u, "(a|b).c");
+    CHECK_EQ(FirstBytes(FromRegex("a*.b*.c")), string("abc"), "through nullable prefixes");
+
+    for (const char *nullable : {"a*", "(a|b)*", "a*.b*", "(a.b)*|c"})
+    {
+        Prefilter disabled = FromRegex(nullable);
+        CHECK_EQ(disabled.Enabled(), false, nullable);
+        CHECK_EQ(disabled.NextCandidate("xyz", 1), 1u, nullable);
+    }
+
+    // FromPostfix is the same analysis without the DAG
+    mt19937 rng(11);
+    for (int i = 0; i < 300; i++)
+    {
+        string regex = RandomRegex(rng, 5);
+        Prefilter dag = FromRegex(regex);
+        Prefilter tree = Prefilter::FromPostfix(InfixToPostfix(regex));
+        CHECK_EQ(dag.Enabled(), tree.Enabled(), regex);
+        CHECK_EQ(dag.Literal(), tree.Literal(), regex);
+        CHECK_EQ(FirstBytes(dag), FirstBytes(tree), regex);
+    }
+}
+
+// what every kernel must find
+static size_t Expected(const Prefilter &prefilter, string_view text, size_t pos)
+{
+    if (!prefilter.Literal().empty())
+        return text.find(prefilter.Literal(), pos);
+    for (size_t i = pos; i < text.size(); i++)
+        if (prefilter.IsFirstByte(text[i]))
+            return i;
+    return string_view::npos;
+}
+
+static void Kernels()
+{
+    vector<string> kernels = Prefilter::Kernels();
+    CHECK(!kernels.empty());
+    CHECK_EQ(kernels.front(), string(Prefilter::Kernel()), "the best kernel is in use");
+    CHECK_EQ(kernels.back(), string("scalar"), "scalar always runs");
+    CHECK(!Prefilter::UseKernel("neon-on-x86"));
+
+    // 1-3 first bytes take the vector path, 4 the table, the rest literals
+    vector<Prefilter> prefilters;
+    for (const char *bytes : {"d", "de", "cde", "bcde"})
+    {
+        array<bool, 256> first{};
+        for (char c : string(bytes))
+            first[(unsigned char)c] = true;
+        prefilters.push_back(Prefilter(first, ""));
+    }
+    for (string literal : vector<string>{"de", "dd", "ede", "abcde", string(40, 'e')})
+    {
+        array<bool, 256> first{};
+        first[(unsigned char)literal[0]] = true;
+        prefilters.push_back(Prefilter(first, literal));
+    }
+
+    mt19937 rng(110);
+    for (const string &kernel : kernels)
+    {
+        CHECK(Prefilter::UseKernel(kernel));
+        CHECK_EQ(string(Prefilter::Kernel()), kernel, "switched");
+        for (int i = 0; i < 300; i++)
+        {
+            // mostly a..c, so d and e are rare and found anywhere, tails included
+            string text = RandomText(rng, 100, "abcabcabcabcabcde");
+            for (const Prefilter &prefilter : prefilters)
+                for (size_t pos = 0; pos <= text.size(); pos++)
+                    CHECK_EQ(prefilter.NextCandidate(text, pos), Expected(prefilter, text, pos),
+                             kernel << " on " << text << " at " << pos << ", literal " << prefilter.Literal());
+        }
+        // the last bytes of a long buffer
+        string text(1000, 'a');
+        for (size_t tail = 0; tail < 40; tail++)
+        {
+            string shifted = text.substr(0, 1000 - tail) + "de" + string(tail, 'a');
+            for (const Prefilter &prefilter : prefilters)
+                CHECK_EQ(prefilter.NextCandidate(shifted, 0), Expected(prefilter, shifted, 0),
+                         kernel << " with " << tail << " bytes after, literal " << prefilter.Literal());
+        }
+    }
+    Prefilter::UseKernel(kernels.front());
+}
+
+int main()
+{
+    Analysis();
+    Kernels();
+    return TestResult();
+}
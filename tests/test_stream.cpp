@@ -0,0 +1,91 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include "check.h"
+#include "reference.h"
+#include "../include/StreamMatcher.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// StreamMatcher finds what find_all finds over the whole stream, for every
+// chunk size, and stays linear when attempts restart over a long carry
+//---------------------------------------------------------------------------------
+
+static vector<pair<size_t, size_t>> Stream(const CompiledDFA &table, string_view text, size_t chunkSize,
+                                           size_t maxMatch, size_t &truncated)
+{
+    vector<pair<size_t, size_t>> found;
+    StreamMatcher matcher(table, [&](size_t begin, size_t end) { found.push_back({begin, end}); }, maxMatch);
+    for (size_t pos = 0; pos < text.size(); pos += chunkSize)
+        matcher.Feed(text.substr(pos, chunkSize));
+    matcher.Finish();
+    CHECK_EQ(matcher.Matches(), found.size(), "match count");
+    truncated = matcher.Truncated();
+    return found;
+}
+
+static void AgainstReference()
+{
+    mt19937 rng(9);
+    for (int i = 0; i < 200; i++)
+    {
+        string regex = RandomRegex(rng, 4);
+        ReferenceRegex reference(regex);
+        DFA dfa = regexToDFA(regex);
+        for (int j = 0; j < 10; j++)
+        {
+            string text = RandomText(rng, 24);
+            vector<pair<size_t, size_t>> expected = reference.FindAll(text);
+            for (size_t chunkSize : {1, 2, 3, 7, 64})
+            {
+                size_t truncated = 0;
+                CHECK(Stream(dfa.getCompiled(), text, chunkSize, StreamMatcher::DEFAULT_MAX_MATCH, truncated) ==
+                      expected);
+                CHECK_EQ(truncated, 0u, regex << " on " << text);
+
+                // with a small cap the result only differs when an attempt was cut off
+                vector<pair<size_t, size_t>> capped = Stream(dfa.getCompiled(), text, chunkSize, 4, truncated);
+                if (truncated == 0)
+                    CHECK(capped == expected);
+            }
+        }
+    }
+}
+
+static double SecondsFor(const CompiledDFA &table, const string &text, size_t maxMatch,
+                         vector<pair<size_t, size_t>> &found, size_t &truncated)
+{
+    auto start = chrono::steady_clock::now();
+    found = Stream(table, text, 64 << 10, maxMatch, truncated);
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void RestartsStayLinear()
+{
+    // every attempt lives to the 'c': rescanning the carry after each restart
+    // took seconds per 100 KB and grew with the square of the length
+    DFA dfa = regexToDFA("a*.b");
+    vector<pair<size_t, size_t>> found;
+    size_t truncated = 0;
+
+    string text = string(1 << 19, 'a') + "cab";
+    CHECK(SecondsFor(dfa.getCompiled(), text, StreamMatcher::DEFAULT_MAX_MATCH, found, truncated) < 5);
+    CHECK(found == (vector<pair<size_t, size_t>>{{text.size() - 2, text.size()}}));
+    CHECK_EQ(truncated, 0u, "512 KiB of a");
+
+    // past the cap attempts are cut off and counted, and the scan is still linear
+    text = string(4 << 20, 'a') + "b";
+    CHECK(SecondsFor(dfa.getCompiled(), text, 1 << 16, found, truncated) < 5);
+    CHECK(truncated > 0);
+    CHECK(!found.empty() && found.back().second == text.size());
+}
+
+int main()
+{
+    AgainstReference();
+    RestartsStayLinear();
+    return TestResult();
+}
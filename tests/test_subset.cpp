@@ -0,0 +1,66 @@
+#include <string>
+#include "check.h"
+#include "reference.h"
+#include "../include/ThreadPool.h"
+#include "../src/converter.hpp"
+
+using namespace std;
+
+//---------------------------------------------------------------------------------
+// NFAtoDFAParallel builds the same table as NFAtoDFA, state numbers included,
+// and a tripped limit stops every worker
+//---------------------------------------------------------------------------------
+
+static string BlowUp(int n)
+{
+    string regex = "(a|b)*.a";
+    for (int i = 0; i < n; i++)
+        regex += ".(a|b)";
+    return regex;
+}
+
+static void SameAsSequential()
+{
+    mt19937 rng(21);
+    for (size_t threads : {2, 4})
+    {
+        ThreadPool pool(threads);
+        for (int i = 0; i < 150; i++)
+        {
+            string regex = i % 10 == 0 ? BlowUp(i / 10) : RandomRegex(rng, 5);
+            NFA nfa = PostfixToNFA(InfixToPostfix(regex));
+            DFA sequential = NFAtoDFA(nfa);
+            DFA parallel = NFAtoDFAParallel(nfa, pool);
+            CHECK(SameTable(sequential.getCompiled(), parallel.getCompiled()));
+        }
+    }
+}
+
+static void LimitStopsWorkers()
+{
+    ThreadPool pool(4);
+    NFA nfa = PostfixToNFA(InfixToPostfix(BlowUp(14)));
+    CompileLimits limits;
+    limits.max_states = 100;
+    bool thrown = false;
+    try
+    {
+        NFAtoDFAParallel(nfa, pool, nullptr, limits);
+    }
+    catch (const DFALimitExceeded &e)
+    {
+        thrown = e.Limit() == CompileLimit::STATES;
+    }
+    CHECK(thrown);
+
+    // the pool is still usable afterwards
+    CHECK(SameTable(NFAtoDFA(nfa, nullptr, CompileLimits()).getCompiled(),
+                    NFAtoDFAParallel(nfa, pool).getCompiled()));
+}
+
+int main()
+{
+    SameAsSequential();
+    LimitStopsWorkers();
+    return TestResult();
+}